@@ -0,0 +1,230 @@
+#include "AdaptiveHuffman.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace {
+    constexpr char kMagic[4] = {'H', 'U', 'F', 'A'};
+
+    // a new word is spelled out 5 bits per character: 1-26 = 'a'-'z', 27 = apostrophe, 0 = end of the word
+    constexpr unsigned kLetterBits = 5;
+    constexpr unsigned kApostrophe = 27;
+
+    unsigned letterCode(const char c) {
+        if (c >= 'a' && c <= 'z')
+            return static_cast<unsigned>(c - 'a') + 1;
+        if (c == '\'')
+            return kApostrophe;
+        return 0; // not something the scanner produces
+    }
+}
+
+
+AdaptiveHuffmanModel::AdaptiveHuffmanModel() {
+    // the tree starts out as nothing but the NYT leaf
+    nodes_.emplace_back();
+    order_.push_back(0);
+    nyt_ = 0;
+}
+
+
+std::int32_t AdaptiveHuffmanModel::leafOf(const std::string_view word) const {
+    const auto id = words_.find(word);
+    return id ? leafOfWord_[*id] : -1;
+}
+
+
+void AdaptiveHuffmanModel::codeOf(std::int32_t node, std::vector<unsigned char>& bits) const {
+    // climb to the root, noting which side we came up from, then flip it around
+    bits.clear();
+    for (std::int32_t parent = nodes_[node].parent; parent >= 0; node = parent, parent = nodes_[node].parent)
+        bits.push_back(nodes_[parent].child[1] == node ? 1 : 0);
+    std::reverse(bits.begin(), bits.end());
+}
+
+
+void AdaptiveHuffmanModel::add(const std::string_view word) {
+    // the NYT leaf becomes an inner node: a new NYT on the left, the new word's leaf on the right
+    const std::int32_t parent = nyt_;
+    const auto leaf = static_cast<std::int32_t>(nodes_.size());
+    const std::int32_t newNyt = leaf + 1;
+
+    nodes_.resize(nodes_.size() + 2);
+    nodes_[parent].child[0] = newNyt;
+    nodes_[parent].child[1] = leaf;
+
+    nodes_[leaf].parent = parent;
+    nodes_[leaf].order = static_cast<std::int32_t>(order_.size());
+    nodes_[leaf].word = words_.intern(word);
+    order_.push_back(leaf);
+
+    nodes_[newNyt].parent = parent;
+    nodes_[newNyt].order = static_cast<std::int32_t>(order_.size());
+    order_.push_back(newNyt);
+
+    leafOfWord_.push_back(leaf);
+    nyt_ = newNyt;
+
+    // the new leaf goes from 0 to 1, like any other increment
+    increment(leaf);
+}
+
+
+void AdaptiveHuffmanModel::increment(std::int32_t node) {
+    // FGK: on the way up to the root, move each node to the front of its weight block before bumping its weight,
+    // so the nodes stay sorted by weight (the sibling property) and the tree stays a Huffman tree
+    while (node >= 0) {
+        const std::int32_t leader = blockLeader(node);
+        if (leader != node && leader != nodes_[node].parent)
+            swapNodes(node, leader);
+
+        nodes_[node].weight++;
+        node = nodes_[node].parent;
+    }
+}
+
+
+std::int32_t AdaptiveHuffmanModel::blockLeader(const std::int32_t node) const {
+    // order_ is sorted heaviest first, so the first node as light as this one is where its block starts
+    const std::uint64_t weight = nodes_[node].weight;
+    const auto first = std::partition_point(order_.begin(), order_.begin() + nodes_[node].order,
+                                            [&](const std::int32_t other) { return nodes_[other].weight > weight; });
+    return *first;
+}
+
+
+void AdaptiveHuffmanModel::swapNodes(const std::int32_t a, const std::int32_t b) {
+    // swap the two subtrees' places in the tree...
+    Node& nodeA = nodes_[a];
+    Node& nodeB = nodes_[b];
+    const std::int32_t parentA = nodeA.parent;
+    const std::int32_t parentB = nodeB.parent;
+
+    if (parentA == parentB)
+        std::swap(nodes_[parentA].child[0], nodes_[parentA].child[1]);
+    else {
+        nodes_[parentA].child[nodes_[parentA].child[1] == a ? 1 : 0] = b;
+        nodes_[parentB].child[nodes_[parentB].child[1] == b ? 1 : 0] = a;
+        nodeA.parent = parentB;
+        nodeB.parent = parentA;
+    }
+
+    // ...and in the weight order
+    std::swap(order_[nodeA.order], order_[nodeB.order]);
+    std::swap(nodeA.order, nodeB.order);
+}
+
+
+AdaptiveHuffmanEncoder::AdaptiveHuffmanEncoder(std::ostream& os) : writer_(os, false) {
+    // no header beyond the magic: the codes build themselves as the tokens go by
+    os.write(kMagic, sizeof kMagic);
+}
+
+
+error_type AdaptiveHuffmanEncoder::put(const std::string_view token) {
+    // an empty word would read back as the end of the stream, and only letters can be spelled out
+    if (token.empty() || std::any_of(token.begin(), token.end(), [](const char c) { return letterCode(c) == 0; })) {
+        std::cerr << "Error: Token '" << token << "' can't be written to an adaptive Huffman stream\n";
+        return FAILED_TO_WRITE_FILE;
+    }
+
+    // a word we've seen: its current code. a new one: the NYT code, then the word itself
+    if (const std::int32_t leaf = model_.leafOf(token); leaf >= 0) {
+        putNode(leaf);
+        model_.increment(leaf);
+    }
+    else {
+        putNode(model_.nytLeaf());
+        putSpelling(token);
+        model_.add(token);
+    }
+
+    return NO_ERROR;
+}
+
+
+error_type AdaptiveHuffmanEncoder::finish() {
+    // end of stream: a "new word" with nothing in it
+    putNode(model_.nytLeaf());
+    putSpelling({});
+    return writer_.finish();
+}
+
+
+void AdaptiveHuffmanEncoder::putNode(const std::int32_t node) {
+    model_.codeOf(node, path_);
+
+    // hand the path to the bit writer in pieces of up to 56 bits
+    for (std::size_t i = 0; i < path_.size(); ) {
+        const std::size_t end = std::min(path_.size(), i + 56);
+        std::uint64_t bits = 0;
+        for (std::size_t j = i; j < end; ++j)
+            bits = (bits << 1) | path_[j];
+        writer_.put(bits, static_cast<unsigned>(end - i));
+        i = end;
+    }
+}
+
+
+void AdaptiveHuffmanEncoder::putSpelling(const std::string_view word) {
+    for (const char c : word)
+        writer_.put(letterCode(c), kLetterBits);
+    writer_.put(0, kLetterBits);
+}
+
+
+error_type decodeAdaptiveHuffman(const unsigned char* data, const std::size_t bytes, std::string& out) {
+    // make sure it's actually an adaptive stream
+    if (bytes < sizeof kMagic || std::memcmp(data, kMagic, sizeof kMagic) != 0)
+        return INVALID_FILE_FORMAT;
+
+    AdaptiveHuffmanModel model;
+    BitReader reader(data + sizeof kMagic, bytes - sizeof kMagic);
+    std::uint64_t remaining = (bytes - sizeof kMagic) * 8;
+    std::string word;
+
+    while (true) {
+        // follow the bits down to a leaf
+        std::int32_t node = model.root();
+        while (!model.isLeaf(node)) {
+            if (remaining == 0)
+                return INVALID_FILE_FORMAT; // ran out before the end-of-stream marker
+            node = model.child(node, reader.takeBit());
+            remaining--;
+        }
+
+        // a word we already know
+        if (node != model.nytLeaf()) {
+            out += model.wordOf(node);
+            out += '\n';
+            model.increment(node);
+            continue;
+        }
+
+        // the NYT leaf: a new word follows, spelled out (an empty one ends the stream)
+        word.clear();
+        while (true) {
+            if (remaining < kLetterBits)
+                return INVALID_FILE_FORMAT;
+            reader.refill();
+            const auto letter = static_cast<unsigned>(reader.peek(kLetterBits));
+            reader.consume(kLetterBits);
+            remaining -= kLetterBits;
+
+            if (letter == 0)
+                break;
+            if (letter > kApostrophe)
+                return INVALID_FILE_FORMAT;
+            word += letter == kApostrophe ? '\'' : static_cast<char>('a' + letter - 1);
+        }
+
+        if (word.empty())
+            return NO_ERROR;
+
+        out += word;
+        out += '\n';
+        model.add(word);
+    }
+}
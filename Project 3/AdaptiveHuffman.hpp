@@ -0,0 +1,93 @@
+#ifndef PROJECT_3_ADAPTIVEHUFFMAN_HPP
+#define PROJECT_3_ADAPTIVEHUFFMAN_HPP
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BitWriter.hpp"
+#include "Vocabulary.hpp"
+#include "utils.hpp"
+
+
+// One-pass (adaptive) Huffman coding of words, FGK style.
+// Encoder and decoder start from the same empty tree and update it the same way after every token, so the codes
+// never have to be sent: no counting pass, no .hdr, and each token is written the moment it arrives.
+// A word's first appearance is sent as the code of the NYT ("not yet transmitted") leaf followed by the word
+// spelled out 5 bits per character; an empty spelling marks the end of the stream.
+//
+// Stream layout: "HUFA", then the bits (first bit = high bit of the first byte), zero-padded to a whole byte.
+class AdaptiveHuffmanModel {
+public:
+    AdaptiveHuffmanModel();
+
+    // Leaf of a word seen before, or -1.
+    [[nodiscard]] std::int32_t leafOf(std::string_view word) const;
+    [[nodiscard]] std::int32_t nytLeaf() const noexcept { return nyt_; }
+
+    // Walk down one step from 'node' (0 = left, 1 = right).
+    [[nodiscard]] std::int32_t child(std::int32_t node, unsigned bit) const { return nodes_[node].child[bit]; }
+    [[nodiscard]] std::int32_t root() const noexcept { return 0; }
+    [[nodiscard]] bool isLeaf(std::int32_t node) const { return nodes_[node].child[0] < 0; }
+    [[nodiscard]] const std::string& wordOf(std::int32_t leaf) const { return words_.word(nodes_[leaf].word); }
+
+    // Code of 'node': the path from the root, first bit first.
+    void codeOf(std::int32_t node, std::vector<unsigned char>& bits) const;
+
+    // Count one more occurrence of a known word's leaf / add a new word (splitting the NYT leaf). Both rebalance.
+    void increment(std::int32_t leaf);
+    void add(std::string_view word);
+
+private:
+    struct Node {
+        std::int32_t parent = -1;
+        std::int32_t child[2] = {-1, -1}; // both -1 for a leaf
+        std::int32_t order = 0;           // position in order_
+        std::uint32_t word = 0;           // leaves only: id in words_
+        std::uint64_t weight = 0;
+    };
+
+    std::vector<Node> nodes_;
+    // every node, heaviest first (the root is order_[0]); FGK's sibling property keeps this sorted by weight
+    std::vector<std::int32_t> order_;
+    std::vector<std::int32_t> leafOfWord_; // words_ id -> leaf
+    Vocabulary words_;
+    std::int32_t nyt_ = 0;
+
+    [[nodiscard]] std::int32_t blockLeader(std::int32_t node) const;
+    void swapNodes(std::int32_t a, std::int32_t b);
+};
+
+
+// Writes one adaptive Huffman stream. put() each token in order, then finish().
+class AdaptiveHuffmanEncoder {
+public:
+    explicit AdaptiveHuffmanEncoder(std::ostream& os);
+
+    // Fails for a token that isn't lowercase letters and apostrophes (what Scanner produces).
+    error_type put(std::string_view token);
+    error_type finish();
+
+    // Push out everything written so far (except a partial last byte), e.g. after each line of a live stream.
+    void flush() { writer_.flush(); }
+
+    [[nodiscard]] std::uint64_t bitCount() const noexcept { return writer_.bitCount(); }
+
+private:
+    AdaptiveHuffmanModel model_;
+    BitWriter writer_;
+    std::vector<unsigned char> path_; // reused for every code
+
+    void putNode(std::int32_t node);
+    void putSpelling(std::string_view word);
+};
+
+
+// Reads an adaptive Huffman stream back, appending "word\n" per token to 'out'.
+error_type decodeAdaptiveHuffman(const unsigned char* data, std::size_t bytes, std::string& out);
+
+
+#endif //PROJECT_3_ADAPTIVEHUFFMAN_HPP
@@ -3,13 +3,10 @@
 //
 
 #include "BinSearchTree.hpp"
+#include <algorithm>
 #include <cstdint>
 
-BinSearchTree::~BinSearchTree() {
-    destroy(root_);
-}
-
-void BinSearchTree::insert(const std::string& word) {
+void BinSearchTree::insert(const std::string_view word) {
     // call the insertHelper function to do the actual work
     root_ = insertHelper(root_, word);
 }
@@ -44,64 +41,154 @@ void BinSearchTree::inorderCollect(std::vector<std::pair<std::string, int> > &ou
 }
 
 std::size_t BinSearchTree::size() const noexcept {
-    // call helper function to do heavy lifting
-    return sizeHelper(root_);
+    // insert() counts every new word as it goes in
+    return size_;
 }
 
 unsigned BinSearchTree::height() const noexcept {
-    // if the root is null, then height is 0.
-    // otherwise, call helper function to actually figure out the height
-    if (root_ == nullptr)
-        return 0;
-    else
-        return heightHelper(root_);
+    // every node knows the height of its own subtree, so the root already has the answer
+    // (and the root is null for an empty tree, which is height 0)
+    return heightOf(root_);
 }
 
 std::size_t BinSearchTree::minFrequency() const noexcept {
-    // if the root is null, then the minimum frequency is 0.
-    // otherwise, call helper function to actually figure it out
-    if (root_ == nullptr)
-        return 0;
-    return minFreqHelper(root_);
+    // insert() keeps this up to date through the frequency histogram. the one exception is once every
+    // word's count is past the histogram's range; then we count it up once here and cache it again
+    if (minFreqStale_) {
+        minFreq_ = minFreqHelper(root_);
+        minFreqStale_ = false;
+    }
+
+    // an empty tree never set it, so it's still 0
+    return minFreq_;
 }
 
 std::size_t BinSearchTree::maxFrequency() const noexcept {
-    // if the root is null, then the maximum frequency is 0.
-    // otherwise, call helper function to actually figure it out
-    if (root_ == nullptr)
-        return 0;
-    return maxFreqHelper(root_);
+    // counts only ever go up, so insert() just has to remember the biggest one
+    return maxFreq_;
 }
 
+void BinSearchTree::depthHistogram(std::vector<std::size_t>& out) const {
+    // clear any previous output, then call a helper function to do the heavy lifting
+    out.clear();
+    depthHelper(root_, 0, out);
+}
 
 
 
 
-void BinSearchTree::destroy(TreeNode* node) noexcept {
-    // if the node is null, there's nothing to destroy
-    if (node == nullptr)
-        return;
-
-    // otherwise, there's stuff to destroy, so destroy it
-    destroy(node->left);
-    destroy(node->right);
-    delete node;
-}
 
 TreeNode* BinSearchTree::insertHelper(TreeNode* node, const std::string_view word) {
     // if the node is null, then we have reached the end of the tree.
     // so, make a new node there
-    if (node == nullptr)
-        return new TreeNode(word);
+    if (node == nullptr) {
+        countChanged(0);
+        return arena_.make(word);
+    }
 
     // otherwise, find where it should go (to the left or the right)
     // if it happens to be a duplicate, don't add a new node, just increment that node's frequency
-    if (word < node->word)
+    // (the shape didn't change, so there's nothing to rebalance)
+    const int order = word.compare(node->word);
+    if (order < 0)
         node->left = insertHelper(node->left, word);
-    else if (word > node->word)
+    else if (order > 0)
         node->right = insertHelper(node->right, word);
-    else
+    else {
+        countChanged(node->count);
         node->count += 1;
+        return node;
+    }
+
+    // a new node went in somewhere below us, so fix up the balance on the way back up
+    return rebalance(node);
+}
+
+void BinSearchTree::countChanged(const std::size_t from) {
+    // one word's count just went from 'from' to 'from + 1' (from 0 means it's a new word)
+    const std::size_t to = from + 1;
+
+    // move the word to its new histogram slot
+    if (from > 0 && from < kFreqHistogramLimit)
+        freqHistogram_[from] -= 1;
+    if (to < kFreqHistogramLimit) {
+        if (freqHistogram_.size() <= to)
+            freqHistogram_.resize(to + 1, 0);
+        freqHistogram_[to] += 1;
+    }
+
+    if (to > maxFreq_)
+        maxFreq_ = to;
+
+    // a new word always has the smallest possible count
+    if (from == 0) {
+        size_ += 1;
+        minFreq_ = 1;
+        minFreqStale_ = false;
+    }
+    // if the last word with the minimum count just moved up, the minimum moves up with it.
+    // past the histogram we can't tell whether it was the last one, so recount when asked
+    else if (from == minFreq_ && !minFreqStale_) {
+        if (from >= kFreqHistogramLimit)
+            minFreqStale_ = true;
+        else if (freqHistogram_[from] == 0)
+            minFreq_ = to;
+    }
+}
+
+unsigned BinSearchTree::heightOf(const TreeNode* node) noexcept {
+    // a missing subtree has height 0
+    return node == nullptr ? 0 : node->height;
+}
+
+void BinSearchTree::updateHeight(TreeNode* node) noexcept {
+    // one more than the taller child
+    node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+}
+
+TreeNode* BinSearchTree::rotateLeft(TreeNode* node) noexcept {
+    // the right child moves up and 'node' becomes its left child
+    TreeNode* pivot = node->right;
+    node->right = pivot->left;
+    pivot->left = node;
+
+    // 'node' is now below the pivot, so it gets updated first
+    updateHeight(node);
+    updateHeight(pivot);
+    return pivot;
+}
+
+TreeNode* BinSearchTree::rotateRight(TreeNode* node) noexcept {
+    // the left child moves up and 'node' becomes its right child
+    TreeNode* pivot = node->left;
+    node->left = pivot->right;
+    pivot->right = node;
+
+    updateHeight(node);
+    updateHeight(pivot);
+    return pivot;
+}
+
+TreeNode* BinSearchTree::rebalance(TreeNode* node) noexcept {
+    updateHeight(node);
+
+    // compare the heights of the two sides; AVL allows them to differ by at most 1
+    const int balance = static_cast<int>(heightOf(node->left)) - static_cast<int>(heightOf(node->right));
+
+    // left side too tall. if the extra height is in the left child's right subtree,
+    // rotate that child first so a single right rotation fixes it (left-right case)
+    if (balance > 1) {
+        if (heightOf(node->left->left) < heightOf(node->left->right))
+            node->left = rotateLeft(node->left);
+        return rotateRight(node);
+    }
+
+    // right side too tall: the mirror image (right-left case, then right-right case)
+    if (balance < -1) {
+        if (heightOf(node->right->right) < heightOf(node->right->left))
+            node->right = rotateRight(node->right);
+        return rotateLeft(node);
+    }
 
     return node;
 }
@@ -131,22 +218,6 @@ void BinSearchTree::inorderHelper(const TreeNode* node, std::vector<std::pair<st
     inorderHelper(node->right, out);
 }
 
-size_t BinSearchTree::sizeHelper(const TreeNode* node) noexcept {
-    // if the node is null, size is 0
-    if (node == nullptr)
-        return 0;
-    // otherwise, get the size recursively
-    return 1 + sizeHelper(node->left) + sizeHelper(node->right);
-}
-
-unsigned BinSearchTree::heightHelper(const TreeNode* node) noexcept {
-    // if the node is null, height is 0
-    if (node == nullptr)
-        return 0;
-    // otherwise, get the height recursively
-    return 1 + std::max(heightHelper(node->left), heightHelper(node->right));
-}
-
 size_t BinSearchTree::minFreqHelper(const TreeNode* node) noexcept {
     // if the node is null, return SIZE_MAX (the largest value size_t can hold).
     // because 0 might be a valid frequency, we return the largest possible value
@@ -168,21 +239,16 @@ size_t BinSearchTree::minFreqHelper(const TreeNode* node) noexcept {
     return result;
 }
 
-size_t BinSearchTree::maxFreqHelper(const TreeNode* node) noexcept {
-    // if the node is null, return 0.
+void BinSearchTree::depthHelper(const TreeNode* node, const std::size_t depth, std::vector<std::size_t>& out) {
+    // if the node is null, there's nothing to count
     if (node == nullptr)
-        return 0;
-
-    // otherwise, find the maximum frequency.
-    size_t leftMax = maxFreqHelper(node->left);
-    size_t rightMax = maxFreqHelper(node->right);
-    size_t currentMax = node->count;
+        return;
 
-    size_t result = currentMax;
-    if (leftMax > result)
-        result = leftMax;
-    if (rightMax > result)
-        result = rightMax;
+    // otherwise, count this node at its depth, then its children one level down
+    if (out.size() <= depth)
+        out.resize(depth + 1, 0);
+    out[depth] += 1;
 
-    return result;
-}
\ No newline at end of file
+    depthHelper(node->left, depth + 1, out);
+    depthHelper(node->right, depth + 1, out);
+}
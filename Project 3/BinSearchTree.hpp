@@ -1,24 +1,30 @@
 #ifndef BINSEARCHTREE_HPP
 #define BINSEARCHTREE_HPP
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <utility>
 #include "TreeNode.hpp"
+#include "NodeArena.hpp"
+#include "WordCounter.hpp"
 
 #include "utils.hpp"
 
 
-class BinSearchTree {
+// Self-balancing (AVL) binary search tree of words and their counts.
+// Every insert rebalances on the way back up, so the height stays within ~1.44 log2(n)
+// no matter what order the words arrive in. It's the default WordCounter (--counter=bst).
+class BinSearchTree final : public WordCounter {
 public:
     BinSearchTree() = default;
-    ~BinSearchTree(); // calls destroy(root_)
+    ~BinSearchTree() override = default; // arena_ frees every node at once
 
     // Insert 'word'; if present, increment its count.
-    void insert(const std::string& word);
+    void insert(std::string_view word) override;
 
     // Convenience: loop over insert(word) for each token.
-    void bulkInsert(const std::vector<std::string>& words);
+    void bulkInsert(const std::vector<std::string>& words) override;
 
     // Queries
     [[nodiscard]] bool contains(std::string_view word) const noexcept;
@@ -26,27 +32,45 @@ public:
 
     // In-order traversal (word-lex order) -> flat list for next stage
     void inorderCollect(std::vector<std::pair<std::string,int>>& out) const;
+    void sortedCounts(std::vector<std::pair<std::string,int>>& out) const override { inorderCollect(out); }
 
-    // Metrics
-    [[nodiscard]] std::size_t size() const noexcept;  // distinct words
-    [[nodiscard]] unsigned height() const noexcept;   // empty tree = 0
-    [[nodiscard]] std::size_t minFrequency() const noexcept;
-    [[nodiscard]] std::size_t maxFrequency() const noexcept;
+    // Metrics - all O(1), kept up to date by insert()
+    [[nodiscard]] std::size_t size() const noexcept override;  // distinct words
+    [[nodiscard]] unsigned height() const noexcept;            // empty tree = 0
+    [[nodiscard]] std::size_t minFrequency() const noexcept override;
+    [[nodiscard]] std::size_t maxFrequency() const noexcept override;
+
+    // out[d] = number of nodes at depth d (the root is depth 0). Walks the whole tree.
+    void depthHistogram(std::vector<std::size_t>& out) const;
 
 private:
+    // counts at or past this don't get a histogram slot (see minFrequency())
+    static constexpr std::size_t kFreqHistogramLimit = 1 << 16;
+
     // TreeNode is defined elsewhere in the project
     TreeNode* root_ = nullptr;
+    NodeArena arena_; // owns every node in the tree
+
+    // cached metrics
+    std::size_t size_ = 0;
+    std::size_t maxFreq_ = 0;
+    mutable std::size_t minFreq_ = 0;
+    mutable bool minFreqStale_ = false;     // min climbed past the histogram; recount on the next query
+    std::vector<std::size_t> freqHistogram_; // freqHistogram_[c] = how many words have count c
 
     // Helpers
-    static void destroy(TreeNode* node) noexcept;
-    static TreeNode* insertHelper(TreeNode *node, std::string_view word);
+    TreeNode* insertHelper(TreeNode *node, std::string_view word);
+    static unsigned heightOf(const TreeNode* node) noexcept; // 0 for nullptr
+    static void updateHeight(TreeNode* node) noexcept;
+    static TreeNode* rotateLeft(TreeNode* node) noexcept;
+    static TreeNode* rotateRight(TreeNode* node) noexcept;
+    static TreeNode* rebalance(TreeNode* node) noexcept;
     static const TreeNode* findNode(const TreeNode* node, std::string_view word) noexcept;
     static void inorderHelper(const TreeNode* node,
                               std::vector<std::pair<std::string,int>>& out);
-    static std::size_t sizeHelper(const TreeNode* node) noexcept;
-    static unsigned heightHelper(const TreeNode* node) noexcept;
+    void countChanged(std::size_t from);
     static size_t minFreqHelper(const TreeNode* node) noexcept;
-    static size_t maxFreqHelper(const TreeNode* node) noexcept;
+    static void depthHelper(const TreeNode* node, std::size_t depth, std::vector<std::size_t>& out);
 };
 
 #endif
@@ -0,0 +1,87 @@
+#include "BitWriter.hpp"
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+error_type writeCodeFileHeader(std::ostream& os, const CodeFileHeader& header) {
+    char bytes[CodeFileHeader::kSize];
+    std::memcpy(bytes, CodeFileHeader::kMagic, 4);
+    bytes[4] = static_cast<char>(CodeFileHeader::kVersion);
+    bytes[5] = static_cast<char>(header.paddingBits);
+    for (int i = 0; i < 8; ++i)
+        bytes[6 + i] = static_cast<char>(header.totalBits >> (8 * i));
+
+    os.write(bytes, sizeof bytes);
+    return os.fail() ? FAILED_TO_WRITE_FILE : NO_ERROR;
+}
+
+error_type readCodeFileHeader(std::istream& is, CodeFileHeader& header) {
+    char bytes[CodeFileHeader::kSize];
+    // too short to even hold a header: the file opened fine, it just isn't one of ours
+    if (!is.read(bytes, sizeof bytes))
+        return INVALID_FILE_FORMAT;
+
+    // make sure it's actually a file we wrote
+    if (std::memcmp(bytes, CodeFileHeader::kMagic, 4) != 0 || static_cast<std::uint8_t>(bytes[4]) != CodeFileHeader::kVersion)
+        return INVALID_FILE_FORMAT;
+
+    header.paddingBits = static_cast<std::uint8_t>(bytes[5]);
+    header.totalBits = 0;
+    for (int i = 0; i < 8; ++i)
+        header.totalBits |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[6 + i])) << (8 * i);
+
+    return NO_ERROR;
+}
+
+
+BitWriter::BitWriter(std::ostream& os, const bool withHeader) : os_(os), withHeader_(withHeader) {
+    buffer_.reserve(kBufferBytes + 8);
+
+    // hold the header's place; the real one is written by finish()
+    if (withHeader_) {
+        headerPos_ = os_.tellp();
+        writeCodeFileHeader(os_, CodeFileHeader{});
+    }
+}
+
+void BitWriter::flush() {
+    // move the whole bytes out of the accumulator first
+    while (accBits_ >= 8) {
+        accBits_ -= 8;
+        buffer_.push_back(static_cast<char>(acc_ >> accBits_));
+    }
+    acc_ &= (std::uint64_t{1} << accBits_) - 1;
+    flushBuffer();
+    os_.flush();
+}
+
+void BitWriter::flushBuffer() {
+    os_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+error_type BitWriter::finish() {
+    // pad the pending bits out to whole bytes (with zeros) and emit them
+    const unsigned bytes = (accBits_ + 7) / 8;
+    const unsigned padding = bytes * 8 - accBits_;
+    const std::uint64_t last = bytes == 0 ? 0 : acc_ << padding;
+    for (int i = static_cast<int>(bytes) - 1; i >= 0; --i)
+        buffer_.push_back(static_cast<char>(last >> (8 * i)));
+    acc_ = 0;
+    accBits_ = 0;
+    flushBuffer();
+
+    // now that the size is known, go back and fill in the header
+    if (withHeader_) {
+        const std::streamoff end = os_.tellp();
+        os_.seekp(headerPos_);
+        writeCodeFileHeader(os_, CodeFileHeader{totalBits_, static_cast<std::uint8_t>(padding)});
+        os_.seekp(end);
+    }
+
+    if (os_.fail() || (withHeader_ && headerPos_ < 0))
+        return FAILED_TO_WRITE_FILE;
+
+    return NO_ERROR;
+}
@@ -0,0 +1,145 @@
+#ifndef PROJECT_3_BITWRITER_HPP
+#define PROJECT_3_BITWRITER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <ios>
+#include <vector>
+
+#include "utils.hpp"
+
+
+// Header at the front of a binary .code file (14 bytes, integers little-endian):
+//   "HUFB"  magic
+//   u8      format version (1)
+//   u8      padding bits after the last code (0-7, always zero bits)
+//   u64     total number of code bits
+// The packed bits follow, first bit of the first code in the most significant bit of the first byte.
+struct CodeFileHeader {
+    static constexpr char kMagic[4] = {'H', 'U', 'F', 'B'};
+    static constexpr std::uint8_t kVersion = 1;
+    static constexpr std::size_t kSize = 14;
+
+    std::uint64_t totalBits = 0;
+    std::uint8_t paddingBits = 0;
+};
+
+// Write 'header' at the current position / read one from the current position.
+error_type writeCodeFileHeader(std::ostream& os, const CodeFileHeader& header);
+error_type readCodeFileHeader(std::istream& is, CodeFileHeader& header);
+
+
+// Packs codes into bytes through a 64-bit accumulator and writes them in large chunks.
+// The constructor reserves room for a CodeFileHeader; finish() pads the last byte and goes back to fill it in,
+// so the stream has to be seekable (a file opened with std::ios::binary is).
+// Without the header (withHeader = false) nothing is ever sought, so any stream will do, pipes included.
+class BitWriter {
+public:
+    explicit BitWriter(std::ostream& os, bool withHeader = true);
+
+    BitWriter(const BitWriter&) = delete;
+    BitWriter& operator=(const BitWriter&) = delete;
+
+    // Append the low 'length' bits of 'bits' (1 <= length <= 64), most significant first.
+    // Bits above 'length' must be zero, which is how PackedCode stores them.
+    void put(std::uint64_t bits, unsigned length) {
+        if (accBits_ + length < 64) {
+            acc_ = (acc_ << length) | bits;
+            accBits_ += length;
+        }
+        else {
+            // top up the accumulator, spill it, and keep whatever didn't fit
+            const unsigned fits = 64 - accBits_;
+            const unsigned rest = length - fits;
+            acc_ = (fits == 64 ? 0 : acc_ << fits) | (bits >> rest);
+            emitWord(acc_);
+            acc_ = rest == 0 ? 0 : bits & ((std::uint64_t{1} << rest) - 1);
+            accBits_ = rest;
+        }
+        totalBits_ += length;
+    }
+
+    // Write out the last partial byte and the header. Call once, after the last put().
+    error_type finish();
+
+    // Push every whole byte so far out to the stream (the partial last byte stays in the accumulator).
+    void flush();
+
+    [[nodiscard]] std::uint64_t bitCount() const noexcept { return totalBits_; }
+
+private:
+    static constexpr std::size_t kBufferBytes = 1 << 16;
+
+    std::ostream& os_;
+    bool withHeader_;
+    std::streamoff headerPos_ = -1;
+    std::uint64_t acc_ = 0;      // the low accBits_ bits are pending
+    unsigned accBits_ = 0;       // always < 64 between calls
+    std::uint64_t totalBits_ = 0;
+    std::vector<char> buffer_;   // whole bytes waiting to be written
+
+    void emitWord(std::uint64_t word) {
+        for (int shift = 56; shift >= 0; shift -= 8)
+            buffer_.push_back(static_cast<char>(word >> shift));
+        if (buffer_.size() >= kBufferBytes)
+            flushBuffer();
+    }
+    void flushBuffer();
+};
+
+
+// Reads bits first-to-last out of a byte array (the other end of BitWriter). The next bits sit at the top of a
+// 64-bit window that refill() tops up 8 bytes at a time.
+class BitReader {
+public:
+    BitReader(const unsigned char* data, std::size_t bytes) : p_(data), end_(data + bytes) {}
+
+    // make sure at least 57 bits are in the window (past the end of the data, zeros come in)
+    void refill() noexcept {
+        if (have_ > 56)
+            return;
+
+        if (end_ - p_ >= 8) {
+            // load 8 bytes at once and keep as many whole bytes as fit
+            std::uint64_t word = 0;
+            for (int i = 0; i < 8; ++i)
+                word = (word << 8) | p_[i];
+            window_ |= word >> have_;
+            const unsigned take = (63 - have_) >> 3;
+            p_ += take;
+            have_ += take * 8;
+        }
+        else {
+            while (have_ <= 56) {
+                const std::uint64_t byte = p_ < end_ ? *p_++ : 0;
+                window_ |= byte << (56 - have_);
+                have_ += 8;
+            }
+        }
+    }
+
+    // the next 'bits' bits (1..57, after a refill()), without using them up
+    [[nodiscard]] std::uint64_t peek(unsigned bits) const noexcept { return window_ >> (64 - bits); }
+
+    void consume(unsigned bits) noexcept {
+        window_ <<= bits;
+        have_ -= bits;
+    }
+
+    unsigned takeBit() noexcept {
+        if (have_ == 0)
+            refill();
+        const auto bit = static_cast<unsigned>(window_ >> 63);
+        consume(1);
+        return bit;
+    }
+
+private:
+    const unsigned char* p_;
+    const unsigned char* end_;
+    std::uint64_t window_ = 0; // the top 'have_' bits are valid
+    unsigned have_ = 0;
+};
+
+
+#endif //PROJECT_3_BITWRITER_HPP
@@ -0,0 +1,253 @@
+#include "BlockContainer.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+#include "BitWriter.hpp"
+#include "HuffmanDecoder.hpp"
+#include "HuffmanTree.hpp"
+#include "Parallel.hpp"
+
+namespace {
+    constexpr char kMagic[4] = {'H', 'U', 'F', 'K'};
+    constexpr std::uint8_t kVersion = 1;
+    constexpr std::uint8_t kReuseFlag = 1;
+
+    void putLittleEndian(std::ostream& os, const std::uint64_t value, const int bytes) {
+        for (int i = 0; i < bytes; ++i)
+            os.put(static_cast<char>(value >> (8 * i)));
+    }
+
+    // reads 'bytes' little-endian bytes at 'p' (which has to have that many before 'end') and moves past them
+    bool getLittleEndian(const unsigned char*& p, const unsigned char* end, std::uint64_t& value, const int bytes) {
+        if (end - p < bytes)
+            return false;
+        value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value |= static_cast<std::uint64_t>(*p++) << (8 * i);
+        return true;
+    }
+
+    // bytes a codebook takes up in a block: the word count, then a length byte, the word and a '\0' per word
+    std::uint64_t storedBytes(const Codebook& codebook) {
+        std::uint64_t bytes = 4;
+        for (std::size_t i = 0; i < codebook.size(); ++i)
+            bytes += codebook.word(i).size() + 2;
+        return bytes;
+    }
+}
+
+
+BlockEncoder::BlockEncoder(std::ostream& os, const std::uint64_t blockTokens, const unsigned threads)
+    : os_(os),
+      // a block's counts go through buildFromCounts, which takes them as ints
+      blockTokens_(std::clamp<std::uint64_t>(blockTokens, 1, INT_MAX)),
+      batchSize_(resolveThreadCount(threads)) {
+    os_.write(kMagic, sizeof kMagic);
+    os_.put(static_cast<char>(kVersion));
+}
+
+
+error_type BlockEncoder::put(const std::string_view token) {
+    if (pending_.empty() || pending_.back().ids.size() == blockTokens_) {
+        // every pending block is full: write them out before starting another
+        if (pending_.size() == batchSize_) {
+            if (error_type status = writePending(); status != NO_ERROR)
+                return status;
+        }
+        pending_.emplace_back();
+    }
+
+    Block& block = pending_.back();
+    const std::uint32_t id = block.words.intern(token);
+    if (id == block.counts.size())
+        block.counts.push_back(0);
+    block.counts[id]++;
+    block.ids.push_back(id);
+
+    return NO_ERROR;
+}
+
+
+error_type BlockEncoder::finish() {
+    if (error_type status = writePending(); status != NO_ERROR)
+        return status;
+
+    os_.flush();
+    return os_.fail() ? FAILED_TO_WRITE_FILE : NO_ERROR;
+}
+
+
+error_type BlockEncoder::writePending() {
+    if (pending_.empty())
+        return NO_ERROR;
+
+    // fitting a codebook to each block doesn't depend on any other block...
+    runOnThreads(pending_.size(), [&](const std::size_t i) { fit(pending_[i]); });
+
+    // ...but whether to reuse the previous one does, so that's decided in order
+    std::vector<const Codebook*> use(pending_.size());
+    const Codebook* inEffect = blocks_ == 0 ? nullptr : &previous_;
+
+    for (std::size_t i = 0; i < pending_.size(); ++i) {
+        Block& block = pending_[i];
+        const std::uint64_t fittedCost = block.fittedBits + 8 * storedBytes(block.fitted);
+
+        // what the tokens would cost with the codebook already in effect (if it has every word in the block)
+        bool covered = inEffect != nullptr;
+        std::uint64_t reuseCost = 0;
+        for (std::uint32_t id = 0; covered && id < block.counts.size(); ++id) {
+            const PackedCode* code = inEffect->find(block.words.word(id));
+            covered = code != nullptr;
+            if (covered)
+                reuseCost += block.counts[id] * code->length;
+        }
+
+        block.reuse = covered && reuseCost <= fittedCost;
+        if (!block.reuse)
+            inEffect = &block.fitted;
+        use[i] = inEffect;
+    }
+
+    runOnThreads(pending_.size(), [&](const std::size_t i) { encode(pending_[i], *use[i]); });
+
+    // out they go, in order
+    for (const Block& block : pending_) {
+        os_.write(block.bytes.data(), static_cast<std::streamsize>(block.bytes.size()));
+        blocks_++;
+        codeBits_ += block.bits;
+        if (block.reuse)
+            reused_++;
+        else
+            codebookBytes_ += storedBytes(block.fitted);
+    }
+
+    // the last new codebook is the one the next batch can reuse
+    for (auto it = pending_.rbegin(); it != pending_.rend(); ++it) {
+        if (!it->reuse) {
+            previous_ = std::move(it->fitted);
+            break;
+        }
+    }
+    pending_.clear();
+
+    return os_.fail() ? FAILED_TO_WRITE_FILE : NO_ERROR;
+}
+
+
+void BlockEncoder::fit(Block& block) {
+    // the same Huffman tree the whole-file path builds, just over this block's counts
+    std::vector<std::pair<std::string, int>> counts;
+    counts.reserve(block.counts.size());
+    for (std::uint32_t id = 0; id < block.counts.size(); ++id)
+        counts.emplace_back(block.words.word(id), static_cast<int>(block.counts[id]));
+    std::sort(counts.begin(), counts.end());
+
+    HuffmanTree tree = HuffmanTree::buildFromCounts(counts, HuffmanBuild::TwoQueue);
+    if (tree.codesFit())
+        tree.makeCanonical();
+    else
+        tree.limitCodeLengths(Codebook::kMaxCodeLength);
+
+    block.fitted = tree.codebook();
+    block.fittedBits = tree.encodedBits();
+}
+
+
+void BlockEncoder::encode(Block& block, const Codebook& codebook) {
+    const std::vector<PackedCode> codes = codebook.indexedBy(block.words);
+    block.bits = 0;
+    for (std::uint32_t id = 0; id < block.counts.size(); ++id)
+        block.bits += block.counts[id] * codes[id].length;
+
+    std::ostringstream out(std::ios::out | std::ios::binary);
+    out.put(static_cast<char>(block.reuse ? kReuseFlag : 0));
+    putLittleEndian(out, block.ids.size(), 8);
+    putLittleEndian(out, block.bits, 8);
+
+    if (!block.reuse) {
+        putLittleEndian(out, codebook.size(), 4);
+        for (std::size_t i = 0; i < codebook.size(); ++i) {
+            out.put(static_cast<char>(codebook.code(i).length));
+            out << codebook.word(i) << '\0';
+        }
+    }
+
+    BitWriter writer(out, false);
+    for (const std::uint32_t id : block.ids)
+        writer.put(codes[id].bits, codes[id].length);
+    writer.finish();
+
+    block.bytes = std::move(out).str();
+
+    // the tokens aren't needed any more, and a batch can hold a lot of them
+    block.ids = {};
+}
+
+
+error_type decodeBlocks(const unsigned char* data, const std::size_t bytes, std::string& out) {
+    const unsigned char* p = data;
+    const unsigned char* const end = data + bytes;
+
+    // make sure it's actually a block container
+    if (bytes < sizeof kMagic + 1 || std::memcmp(p, kMagic, sizeof kMagic) != 0 || p[sizeof kMagic] != kVersion)
+        return INVALID_FILE_FORMAT;
+    p += sizeof kMagic + 1;
+
+    HuffmanDecoder decoder;
+    bool haveCodebook = false;
+
+    while (p < end) {
+        const std::uint8_t flags = *p++;
+        std::uint64_t tokens = 0;
+        std::uint64_t bits = 0;
+        if ((flags & ~kReuseFlag) != 0 || !getLittleEndian(p, end, tokens, 8) || !getLittleEndian(p, end, bits, 8))
+            return INVALID_FILE_FORMAT;
+
+        if (flags & kReuseFlag) {
+            if (!haveCodebook)
+                return INVALID_FILE_FORMAT; // nothing to reuse
+        }
+        else {
+            // a new codebook: (length, word) pairs in canonical order
+            std::uint64_t words = 0;
+            if (!getLittleEndian(p, end, words, 4))
+                return INVALID_FILE_FORMAT;
+
+            std::vector<std::pair<std::string, unsigned>> lengths;
+            for (std::uint64_t i = 0; i < words; ++i) {
+                if (p == end)
+                    return INVALID_FILE_FORMAT;
+                const unsigned length = *p++;
+                const auto* terminator = static_cast<const unsigned char*>(std::memchr(p, '\0', static_cast<std::size_t>(end - p)));
+                if (terminator == nullptr || length == 0 || length > Codebook::kMaxCodeLength)
+                    return INVALID_FILE_FORMAT;
+
+                lengths.emplace_back(std::string(reinterpret_cast<const char*>(p), static_cast<std::size_t>(terminator - p)), length);
+                p = terminator + 1;
+            }
+
+            decoder = HuffmanDecoder(Codebook::canonical(std::move(lengths)));
+            haveCodebook = true;
+        }
+
+        // the block's bits: exactly 'tokens' whole codes, then padding
+        const std::uint64_t blockBytes = (bits + 7) / 8;
+        if (static_cast<std::uint64_t>(end - p) < blockBytes)
+            return INVALID_FILE_FORMAT;
+
+        const std::size_t before = out.size();
+        std::uint64_t bit = 0;
+        if (error_type status = decoder.decodeFrom(p, bits, bit, tokens, out); status != NO_ERROR)
+            return status;
+        if (bit != bits || static_cast<std::uint64_t>(std::count(out.begin() + static_cast<std::ptrdiff_t>(before), out.end(), '\n')) != tokens)
+            return INVALID_FILE_FORMAT;
+
+        p += blockBytes;
+    }
+
+    return NO_ERROR;
+}
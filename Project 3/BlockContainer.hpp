@@ -0,0 +1,79 @@
+#ifndef PROJECT_3_BLOCKCONTAINER_HPP
+#define PROJECT_3_BLOCKCONTAINER_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Codebook.hpp"
+#include "Vocabulary.hpp"
+#include "utils.hpp"
+
+
+// .code as a sequence of independent blocks of (up to) a fixed number of tokens, each with its own canonical codebook
+// fitted to just those tokens, so the codes follow a vocabulary that drifts through a big file. A block whose tokens
+// are cheaper to write with the previous block's codebook (all of them in it, and the saving on bits not worth a new
+// codebook) says so with a flag instead of repeating it. Blocks are written as soon as they fill up (no counting
+// pass over the whole input), and with several threads a batch of full blocks is fitted and encoded in parallel.
+//
+// File layout (integers little-endian):
+//   "HUFK", u8 version (1)
+//   then per block, until the end of the file:
+//     u8   flags (1 = reuse the previous block's codebook)
+//     u64  tokens in the block, u64 code bits in the block
+//     (no reuse flag) u32 words, then per word in canonical order: u8 code length, the word, a '\0'
+//     the code bits, first bit in the high bit of the first byte, zero-padded to a whole byte
+class BlockEncoder {
+public:
+    // blockTokens = tokens per block (0 is taken as 1); threads = blocks fitted/encoded at once (0 = one per core)
+    BlockEncoder(std::ostream& os, std::uint64_t blockTokens, unsigned threads = 1);
+
+    error_type put(std::string_view token);
+
+    // Write the last (partial) block. Call once, after the last put().
+    error_type finish();
+
+    [[nodiscard]] std::uint64_t blockCount() const noexcept { return blocks_; }
+    [[nodiscard]] std::uint64_t reusedCount() const noexcept { return reused_; }
+    [[nodiscard]] std::uint64_t codeBits() const noexcept { return codeBits_; }           // code bits, every block
+    [[nodiscard]] std::uint64_t codebookBytes() const noexcept { return codebookBytes_; } // codebooks, every block
+
+private:
+    // one block's tokens, as ids into its own vocabulary
+    struct Block {
+        Vocabulary words;
+        std::vector<std::uint32_t> ids;
+        std::vector<std::uint64_t> counts;     // by id
+
+        Codebook fitted;                       // canonical codes for just this block
+        std::uint64_t fittedBits = 0;          // its tokens' bits with 'fitted'
+        bool reuse = false;                    // written with the previous codebook instead
+        std::uint64_t bits = 0;                // code bits it was written with
+        std::string bytes;                     // the whole encoded block, ready to write
+    };
+
+    std::ostream& os_;
+    std::uint64_t blockTokens_;
+    std::size_t batchSize_;
+    std::vector<Block> pending_;               // full blocks (and the one filling up, last)
+    Codebook previous_;                        // codebook of the last block written
+
+    std::uint64_t blocks_ = 0;
+    std::uint64_t reused_ = 0;
+    std::uint64_t codeBits_ = 0;
+    std::uint64_t codebookBytes_ = 0;
+
+    error_type writePending();
+
+    static void fit(Block& block);
+    static void encode(Block& block, const Codebook& codebook);
+};
+
+
+// Reads a block container back, appending "word\n" per token to 'out'.
+error_type decodeBlocks(const unsigned char* data, std::size_t bytes, std::string& out);
+
+
+#endif //PROJECT_3_BLOCKCONTAINER_HPP
@@ -0,0 +1,54 @@
+#include "Codebook.hpp"
+
+#include <algorithm>
+
+void Codebook::add(const std::string_view word, const PackedCode code) {
+    // the vocabulary hands out ids in order, so a new word's id is exactly its index in codes_
+    const std::uint32_t index = words_.intern(word);
+    if (index == codes_.size())
+        codes_.push_back(code);
+    else
+        codes_[index] = code;
+}
+
+const PackedCode* Codebook::find(const std::string_view word) const {
+    // one hash lookup, then an array index
+    const auto index = words_.find(word);
+    if (!index)
+        return nullptr;
+
+    return &codes_[*index];
+}
+
+std::vector<PackedCode> Codebook::indexedBy(const Vocabulary& vocab) const {
+    // look every vocabulary word up once, so encoding a token id is just an array index
+    std::vector<PackedCode> byId(vocab.size());
+    for (std::uint32_t id = 0; id < vocab.size(); ++id) {
+        if (const PackedCode* code = find(vocab.word(id)))
+            byId[id] = *code;
+    }
+
+    return byId;
+}
+
+Codebook Codebook::canonical(std::vector<std::pair<std::string, unsigned>> lengths) {
+    // canonical order: shortest codes first, ties broken by the word
+    std::sort(lengths.begin(), lengths.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second < b.second : a.first < b.first;
+    });
+
+    Codebook book;
+    std::uint64_t next = 0;
+    unsigned previousLength = lengths.empty() ? 0 : lengths.front().second;
+
+    for (const auto& [word, length] : lengths) {
+        // a longer code continues from the next free prefix, extended with zeros
+        next <<= length - previousLength;
+        previousLength = length;
+
+        book.add(word, PackedCode{next, static_cast<std::uint8_t>(length)});
+        next++;
+    }
+
+    return book;
+}
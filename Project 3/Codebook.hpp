@@ -0,0 +1,54 @@
+#ifndef PROJECT_3_CODEBOOK_HPP
+#define PROJECT_3_CODEBOOK_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Vocabulary.hpp"
+
+
+// A Huffman code packed into an integer: the low 'length' bits of 'bits', first bit of the code most significant.
+struct PackedCode {
+    std::uint64_t bits = 0;
+    std::uint8_t length = 0; // 0 = no code
+};
+
+// Word -> PackedCode table. HuffmanTree builds one when the tree is built and every encode reuses it:
+// a token costs one hash lookup (or one array index, through indexedBy()) instead of a string-keyed map search.
+class Codebook {
+public:
+    // codes can't be longer than the integer they're packed into
+    static constexpr unsigned kMaxCodeLength = 64;
+
+    Codebook() = default;
+
+    // Canonical codes for the given (word, code length) pairs. Entries are ordered by length, then word;
+    // the first gets all zeros and each next one is the previous code plus one (shifted left when the length grows).
+    // Only the lengths matter, so they're all a decoder needs. Lengths must be 1..kMaxCodeLength and come from a real
+    // prefix code (e.g. a Huffman tree's leaf depths).
+    [[nodiscard]] static Codebook canonical(std::vector<std::pair<std::string, unsigned>> lengths);
+
+    // Add 'word' with its code (entries keep the order they were added in).
+    void add(std::string_view word, PackedCode code);
+
+    // Code of 'word', or nullptr if it isn't in the codebook.
+    [[nodiscard]] const PackedCode* find(std::string_view word) const;
+
+    // Codes lined up by the ids in 'vocab' (length 0 where a word has no code).
+    [[nodiscard]] std::vector<PackedCode> indexedBy(const Vocabulary& vocab) const;
+
+    [[nodiscard]] std::size_t size() const noexcept { return codes_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return codes_.empty(); }
+    [[nodiscard]] const std::string& word(std::size_t i) const { return words_.word(static_cast<std::uint32_t>(i)); }
+    [[nodiscard]] const PackedCode& code(std::size_t i) const { return codes_[i]; }
+
+private:
+    Vocabulary words_;              // word -> index into codes_
+    std::vector<PackedCode> codes_;
+};
+
+
+#endif //PROJECT_3_CODEBOOK_HPP
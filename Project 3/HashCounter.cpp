@@ -0,0 +1,36 @@
+#include "HashCounter.hpp"
+
+#include <algorithm>
+
+
+void HashCounter::insert(const std::string_view word) {
+    // a new word gets the next id, so its count goes on the end
+    const std::uint32_t id = words_.intern(word);
+    if (id == counts_.size())
+        counts_.push_back(0);
+
+    maxFreq_ = std::max<std::size_t>(maxFreq_, ++counts_[id]);
+}
+
+void HashCounter::bulkInsert(const std::vector<std::string>& words) {
+    for (const auto& word : words)
+        insert(word);
+}
+
+void HashCounter::sortedCounts(std::vector<std::pair<std::string, int>>& out) const {
+    // collect the words in id order, then put them in word order
+    out.clear();
+    out.reserve(counts_.size());
+    for (std::uint32_t id = 0; id < counts_.size(); ++id)
+        out.emplace_back(words_.word(id), static_cast<int>(counts_[id]));
+
+    std::sort(out.begin(), out.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+}
+
+std::size_t HashCounter::minFrequency() const noexcept {
+    // an empty counter has a minimum of 0, same as the BST
+    if (counts_.empty())
+        return 0;
+    return static_cast<std::size_t>(*std::min_element(counts_.begin(), counts_.end()));
+}
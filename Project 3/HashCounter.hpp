@@ -0,0 +1,36 @@
+#ifndef PROJECT_3_HASHCOUNTER_HPP
+#define PROJECT_3_HASHCOUNTER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Vocabulary.hpp"
+#include "WordCounter.hpp"
+
+
+// Word counts kept by id: the Vocabulary's flat hash table turns each word into its id, and the count is
+// an increment in a plain array. A repeated word costs one hash, usually one slot read and one string compare.
+// Words are only put in order once, when sortedCounts() is asked for.
+class HashCounter final : public WordCounter {
+public:
+    HashCounter() = default;
+
+    void insert(std::string_view word) override;
+    void bulkInsert(const std::vector<std::string>& words) override;
+    void sortedCounts(std::vector<std::pair<std::string, int>>& out) const override;
+
+    [[nodiscard]] std::size_t size() const noexcept override { return words_.size(); }
+    [[nodiscard]] std::size_t minFrequency() const noexcept override; // a scan over the counts
+    [[nodiscard]] std::size_t maxFrequency() const noexcept override { return maxFreq_; }
+
+private:
+    Vocabulary words_;
+    std::vector<std::uint64_t> counts_; // by word id
+    std::size_t maxFreq_ = 0;
+};
+
+
+#endif //PROJECT_3_HASHCOUNTER_HPP
@@ -0,0 +1,309 @@
+#include "HuffmanDecoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+#include "BitWriter.hpp"
+#include "Parallel.hpp"
+
+HuffmanDecoder::HuffmanDecoder(const Codebook& codebook) {
+    // the words themselves, ready to be copied out
+    textStart_.reserve(codebook.size() + 1);
+    for (std::size_t s = 0; s < codebook.size(); ++s) {
+        textStart_.push_back(static_cast<std::uint32_t>(text_.size()));
+        text_ += codebook.word(s);
+        text_ += '\n';
+        longestText_ = std::max(longestText_, codebook.word(s).size() + 1);
+    }
+    textStart_.push_back(static_cast<std::uint32_t>(text_.size()));
+    text_.append(kShortText, '\0');
+    longestText_ = std::max(longestText_, kShortText);
+
+    // a trie of all the codes
+    trie_.emplace_back();
+    for (std::size_t s = 0; s < codebook.size(); ++s) {
+        const PackedCode& code = codebook.code(s);
+        std::int32_t node = 0;
+        for (int b = code.length - 1; b >= 0; --b) {
+            const auto bit = static_cast<unsigned>((code.bits >> b) & 1);
+            if (trie_[node].child[bit] == kNoNode) {
+                trie_[node].child[bit] = static_cast<std::int32_t>(trie_.size());
+                trie_.emplace_back();
+            }
+            node = trie_[node].child[bit];
+        }
+        trie_[node].symbol = static_cast<std::int32_t>(s);
+    }
+
+    // walk every possible window through the trie once, recording the whole codes it starts with
+    table_.resize(std::size_t{1} << kTableBits);
+    for (std::uint32_t window = 0; window < table_.size(); ++window) {
+        TableEntry& entry = table_[window];
+        std::int32_t node = 0;
+        unsigned used = 0;
+
+        for (unsigned i = 0; i < kTableBits; ++i) {
+            const unsigned bit = (window >> (kTableBits - 1 - i)) & 1;
+            node = trie_[node].child[bit];
+            if (node == kNoNode)
+                break;
+
+            if (trie_[node].symbol != kNoNode) {
+                entry.symbols[entry.count++] = trie_[node].symbol;
+                used = i + 1;
+                node = 0;
+                if (entry.count == kMaxSymbolsPerEntry)
+                    break;
+            }
+        }
+
+        entry.bits = static_cast<std::uint8_t>(used);
+
+        // no whole code fits: remember where the walk got to, so decode() can pick it up from there
+        if (entry.count == 0) {
+            entry.symbols[0] = node;
+            entry.bits = kTableBits;
+        }
+    }
+}
+
+
+error_type HuffmanDecoder::readHeader(std::istream& hdr, Codebook& codebook) {
+    codebook = Codebook();
+
+    std::string line;
+    if (!std::getline(hdr, line))
+        return NO_ERROR; // an empty header is an empty codebook
+
+    // canonical: "canonical <words> <longest>", then "<length> <count> <word> ..." lines
+    if (line.rfind("canonical ", 0) == 0) {
+        std::vector<std::pair<std::string, unsigned>> lengths;
+        while (std::getline(hdr, line)) {
+            std::istringstream fields(line);
+            unsigned length = 0;
+            std::size_t count = 0;
+            if (!(fields >> length >> count) || length == 0 || length > Codebook::kMaxCodeLength)
+                return INVALID_FILE_FORMAT;
+
+            std::string word;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (!(fields >> word))
+                    return INVALID_FILE_FORMAT;
+                lengths.emplace_back(word, length);
+            }
+        }
+
+        codebook = Codebook::canonical(std::move(lengths));
+        return NO_ERROR;
+    }
+
+    // otherwise, "word code" per line
+    do {
+        const std::size_t space = line.find(' ');
+        if (space == std::string::npos || line.size() - space - 1 > Codebook::kMaxCodeLength)
+            return INVALID_FILE_FORMAT;
+
+        PackedCode code;
+        for (std::size_t i = space + 1; i < line.size(); ++i) {
+            if (line[i] != '0' && line[i] != '1')
+                return INVALID_FILE_FORMAT;
+            code.bits = (code.bits << 1) | static_cast<std::uint64_t>(line[i] - '0');
+            code.length++;
+        }
+        if (code.length == 0)
+            return INVALID_FILE_FORMAT;
+
+        codebook.add(std::string_view(line).substr(0, space), code);
+    } while (std::getline(hdr, line));
+
+    return NO_ERROR;
+}
+
+
+error_type HuffmanDecoder::loadCodeFile(const std::filesystem::path& path, EncodedBits& bits) {
+    bits = EncodedBits();
+    if (error_type status = bits.mapped.open(path); status != NO_ERROR)
+        return status;
+
+    const std::string_view file = bits.mapped.view();
+
+    // binary: the bits are already packed, right after the header
+    if (file.size() >= 4 && std::memcmp(file.data(), CodeFileHeader::kMagic, 4) == 0) {
+        std::istringstream headerBytes(std::string(file.substr(0, CodeFileHeader::kSize)));
+        CodeFileHeader header;
+        if (error_type status = readCodeFileHeader(headerBytes, header); status != NO_ERROR)
+            return status;
+        if ((header.totalBits + header.paddingBits) / 8 != file.size() - CodeFileHeader::kSize)
+            return INVALID_FILE_FORMAT;
+
+        bits.data = reinterpret_cast<const unsigned char*>(file.data()) + CodeFileHeader::kSize;
+        bits.totalBits = header.totalBits;
+        return NO_ERROR;
+    }
+
+    // ascii: pack the '0'/'1' characters, skipping the line breaks
+    bits.packed.reserve(file.size() / 8 + 1);
+    unsigned char byte = 0;
+    unsigned filled = 0;
+    for (const char ch : file) {
+        if (ch == '\n' || ch == '\r')
+            continue;
+        if (ch != '0' && ch != '1')
+            return INVALID_FILE_FORMAT;
+
+        byte = static_cast<unsigned char>((byte << 1) | (ch - '0'));
+        bits.totalBits++;
+        if (++filled == 8) {
+            bits.packed.push_back(byte);
+            byte = 0;
+            filled = 0;
+        }
+    }
+    if (filled > 0)
+        bits.packed.push_back(static_cast<unsigned char>(byte << (8 - filled)));
+
+    bits.data = bits.packed.data();
+    bits.mapped.close();
+    return NO_ERROR;
+}
+
+
+error_type HuffmanDecoder::decode(const unsigned char* data, const std::uint64_t totalBits, std::string& out) const {
+    // the whole stream is one run from bit 0 to the end
+    std::uint64_t bit = 0;
+    return decodeFrom(data, totalBits, bit, std::numeric_limits<std::uint64_t>::max(), out);
+}
+
+
+error_type HuffmanDecoder::decodeFrom(const unsigned char* data, const std::uint64_t totalBits, std::uint64_t& bit,
+                                      const std::uint64_t maxTokens, std::string& out) const {
+    if (bit >= totalBits || maxTokens == 0)
+        return NO_ERROR;
+    if (table_.empty())
+        return INVALID_FILE_FORMAT; // bits, but no codes to read them with
+
+    // start reading at the byte 'bit' is in, and drop the bits before it
+    BitReader reader(data + bit / 8, static_cast<std::size_t>((totalBits + 7) / 8 - bit / 8));
+    reader.refill();
+    reader.consume(static_cast<unsigned>(bit % 8));
+    std::uint64_t remaining = totalBits - bit;
+    std::uint64_t tokensLeft = maxTokens;
+
+    // words are copied straight into 'out', which grows in big steps whenever a lookup's worth of words might not fit
+    const std::size_t maxPerLookup = kMaxSymbolsPerEntry * longestText_;
+    std::size_t used = out.size();
+    out.resize(used + std::max<std::size_t>(maxPerLookup, std::min<std::uint64_t>(remaining, tokensLeft * 8) / 2));
+    char* dst = out.data() + used;
+    char* limit = out.data() + out.size() - maxPerLookup;
+
+    error_type status = NO_ERROR;
+    while (remaining > 0 && tokensLeft > 0) {
+        if (dst > limit) {
+            used = static_cast<std::size_t>(dst - out.data());
+            out.resize(out.size() * 2);
+            dst = out.data() + used;
+            limit = out.data() + out.size() - maxPerLookup;
+        }
+
+        reader.refill();
+        const TableEntry& entry = table_[reader.peek(kTableBits)];
+
+        // the usual case: one or more whole words, all inside the real bits (and all of them wanted)
+        if (entry.count != 0 && entry.bits <= remaining && entry.count <= tokensLeft) {
+            for (unsigned i = 0; i < entry.count; ++i)
+                dst = putSymbol(entry.symbols[i], dst);
+            reader.consume(entry.bits);
+            remaining -= entry.bits;
+            tokensLeft -= entry.count;
+            continue;
+        }
+
+        // otherwise walk the trie a bit at a time: a code longer than the table, the last few bits of the stream,
+        // or the last few words wanted
+        std::int32_t node = 0;
+        if (entry.count == 0 && kTableBits <= remaining) {
+            node = entry.symbols[0];
+            reader.consume(kTableBits);
+            remaining -= kTableBits;
+        }
+
+        while (node != kNoNode && trie_[node].symbol == kNoNode && remaining > 0) {
+            node = trie_[node].child[reader.takeBit()];
+            remaining--;
+        }
+
+        // the bits ran out mid-code, or spelled out something that isn't a code
+        if (node == kNoNode || trie_[node].symbol == kNoNode) {
+            status = INVALID_FILE_FORMAT;
+            break;
+        }
+
+        dst = putSymbol(trie_[node].symbol, dst);
+        tokensLeft--;
+    }
+
+    out.resize(static_cast<std::size_t>(dst - out.data()));
+    bit = totalBits - remaining;
+    return status;
+}
+
+
+error_type HuffmanDecoder::decodeTokens(const EncodedBits& bits, const SyncIndex& index, const std::uint64_t first,
+                                        const std::uint64_t count, std::string& out) const {
+    if (index.totalBits() != bits.totalBits)
+        return INVALID_FILE_FORMAT; // the index belongs to some other .code file
+
+    // start at the closest sync point, and decode (but don't keep) the tokens between it and 'first'
+    const SyncPoint start = index.pointBefore(first);
+    std::uint64_t bit = start.bit;
+    if (first > start.token) {
+        std::string skipped;
+        if (error_type status = decodeFrom(bits.data, bits.totalBits, bit, first - start.token, skipped); status != NO_ERROR)
+            return status;
+    }
+
+    return decodeFrom(bits.data, bits.totalBits, bit, count, out);
+}
+
+
+error_type HuffmanDecoder::decodeParallel(const EncodedBits& bits, const SyncIndex& index, const unsigned threads,
+                                          std::string& out) const {
+    if (index.totalBits() != bits.totalBits)
+        return INVALID_FILE_FORMAT;
+    if (index.size() == 0)
+        return NO_ERROR;
+
+    // give each thread a run of whole sync intervals
+    const std::size_t parts = std::clamp<std::size_t>(resolveThreadCount(threads), 1, index.size());
+    std::vector<std::string> pieces(parts);
+    std::vector<error_type> statuses(parts, NO_ERROR);
+
+    runOnThreads(parts, [&](const std::size_t part) {
+        const std::size_t firstPoint = index.size() * part / parts;
+        const std::size_t endPoint = index.size() * (part + 1) / parts;
+        const std::uint64_t firstToken = index.point(firstPoint).token;
+        const std::uint64_t endToken = endPoint < index.size() ? index.point(endPoint).token : index.totalTokens();
+
+        std::uint64_t bit = index.point(firstPoint).bit;
+        statuses[part] = decodeFrom(bits.data, bits.totalBits, bit, endToken - firstToken, pieces[part]);
+    });
+
+    for (const error_type status : statuses) {
+        if (status != NO_ERROR)
+            return status;
+    }
+
+    // glue the pieces back together in order
+    std::size_t total = out.size();
+    for (const auto& piece : pieces)
+        total += piece.size();
+    out.reserve(total);
+    for (const auto& piece : pieces)
+        out += piece;
+
+    return NO_ERROR;
+}
@@ -0,0 +1,109 @@
+#ifndef PROJECT_3_HUFFMANDECODER_HPP
+#define PROJECT_3_HUFFMANDECODER_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "Codebook.hpp"
+#include "MappedFile.hpp"
+#include "SyncIndex.hpp"
+#include "utils.hpp"
+
+
+// The bits of a .code file, whichever format it was written in, ready for HuffmanDecoder::decode().
+// A binary file is used in place (memory-mapped); an ASCII one is packed 8 bits to a byte first.
+struct EncodedBits {
+    const unsigned char* data = nullptr; // first bit = high bit of data[0]
+    std::uint64_t totalBits = 0;
+
+    MappedFile mapped;                   // keeps a binary file's bytes alive
+    std::vector<unsigned char> packed;   // an ASCII file's bits, packed
+};
+
+
+// Turns .code bits back into words, table-driven instead of one tree step per bit.
+// Every possible kTableBits-bit window has a precomputed entry: the (up to kMaxSymbolsPerEntry) whole codes it starts
+// with, so one lookup usually decodes several words at once. The rare code longer than kTableBits finishes its
+// walk bit by bit in a small flat trie.
+class HuffmanDecoder {
+public:
+    static constexpr unsigned kTableBits = 12;
+    static constexpr unsigned kMaxSymbolsPerEntry = 3;
+
+    HuffmanDecoder() = default;
+
+    // Build the tables for the codes in 'codebook' (any prefix code; it doesn't have to be canonical).
+    explicit HuffmanDecoder(const Codebook& codebook);
+
+    // Read a .hdr file in either format HuffmanTree::writeHeader produces ("word code" lines, or canonical lengths).
+    static error_type readHeader(std::istream& hdr, Codebook& codebook);
+
+    // Load a .code file, ASCII or binary (told apart by the binary header's magic).
+    static error_type loadCodeFile(const std::filesystem::path& path, EncodedBits& bits);
+
+    // Decode 'totalBits' bits starting at the high bit of data[0], appending "word\n" per token to 'out'
+    // (so the output of a whole file matches the .tokens file). 'out' isn't cleared, so it can be reused across calls.
+    // Fails if the bits don't spell out whole codes.
+    error_type decode(const unsigned char* data, std::uint64_t totalBits, std::string& out) const;
+
+    // Decode at most maxTokens tokens starting at 'bit' (which has to be where a token starts, e.g. a sync point),
+    // stopping early at totalBits. 'bit' is moved to where decoding stopped.
+    error_type decodeFrom(const unsigned char* data, std::uint64_t totalBits, std::uint64_t& bit,
+                          std::uint64_t maxTokens, std::string& out) const;
+
+    // Random access: decode tokens first .. first + count - 1, starting from the closest sync point in 'index'
+    // instead of the beginning of the stream (only the bits from there on are read).
+    error_type decodeTokens(const EncodedBits& bits, const SyncIndex& index, std::uint64_t first, std::uint64_t count,
+                            std::string& out) const;
+
+    // The whole stream, split at sync points into runs decoded on 'threads' threads (0 = one per core).
+    // Appends exactly what decode() would.
+    error_type decodeParallel(const EncodedBits& bits, const SyncIndex& index, unsigned threads,
+                              std::string& out) const;
+
+    [[nodiscard]] std::size_t symbolCount() const noexcept { return textStart_.empty() ? 0 : textStart_.size() - 1; }
+
+private:
+    static constexpr std::int32_t kNoNode = -1;
+
+    // one flat trie node; leaves have a symbol, inner nodes have children
+    struct TrieNode {
+        std::int32_t child[2] = {kNoNode, kNoNode};
+        std::int32_t symbol = kNoNode;
+    };
+
+    // count == 0: no code ends inside the window. 'symbols[0]' is then the trie node the window leads to
+    // (kNoNode if no code starts with these bits at all).
+    struct TableEntry {
+        std::int32_t symbols[kMaxSymbolsPerEntry] = {kNoNode, kNoNode, kNoNode};
+        std::uint8_t count = 0; // whole codes in the window
+        std::uint8_t bits = 0;  // bits they take up
+    };
+
+    std::vector<TrieNode> trie_;             // trie_[0] is the root
+    std::vector<TableEntry> table_;          // indexed by the next kTableBits bits
+    std::string text_;                       // every symbol's "word\n", back to back
+    std::vector<std::uint32_t> textStart_;   // symbol s is text_[textStart_[s] .. textStart_[s + 1])
+
+    std::size_t longestText_ = 0;            // longest "word\n" (at least kShortText)
+
+    // words this long or shorter are copied with one fixed-size copy (text_ and the output both have slack for it)
+    static constexpr std::size_t kShortText = 16;
+
+    // copy symbol's text to 'dst' (which has room for it) and return the end of what was written
+    char* putSymbol(std::int32_t symbol, char* dst) const {
+        const std::uint32_t length = textStart_[symbol + 1] - textStart_[symbol];
+        if (length <= kShortText)
+            std::memcpy(dst, text_.data() + textStart_[symbol], kShortText);
+        else
+            std::memcpy(dst, text_.data() + textStart_[symbol], length);
+        return dst + length;
+    }
+};
+
+
+#endif //PROJECT_3_HUFFMANDECODER_HPP
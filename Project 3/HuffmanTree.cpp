@@ -4,9 +4,12 @@
 
 #include "HuffmanTree.hpp"
 #include "PriorityQueue.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 
-HuffmanTree HuffmanTree::buildFromCounts(const std::vector<std::pair<std::string, int>> &counts) {
+HuffmanTree HuffmanTree::buildFromCounts(const std::vector<std::pair<std::string, int>> &counts, HuffmanBuild method) {
     HuffmanTree tree;
 
     // if the vector from the BST is empty, we have an empty tree
@@ -19,15 +22,27 @@ HuffmanTree HuffmanTree::buildFromCounts(const std::vector<std::pair<std::string
 
     // put all the elements into our vector
     for (const auto& [word, count] : counts) {
-        leaves.push_back(new TreeNode(word, static_cast<size_t>(count)));
+        leaves.push_back(tree.arena_.make(word, static_cast<size_t>(count)));
     }
 
     // edge case: only 1 element
-    if (leaves.size() == 1) {
+    if (leaves.size() == 1)
         tree.root_ = leaves[0];
-        return tree;
-    }
 
+    // merge the nodes to make the huffman tree, and grab the root
+    else if (method == HuffmanBuild::TwoQueue)
+        tree.root_ = mergeWithTwoQueues(tree, std::move(leaves));
+    else
+        tree.root_ = mergeWithPriorityQueue(tree, leaves);
+
+    // work out every code once, up front, so encoding never has to walk the tree
+    tree.buildCodebook();
+
+    return tree;
+}
+
+
+TreeNode* HuffmanTree::mergeWithPriorityQueue(HuffmanTree& tree, const std::vector<TreeNode*>& leaves) {
     // make a priority queue with our vector
     PriorityQueue pq(leaves);
 
@@ -36,20 +51,65 @@ HuffmanTree HuffmanTree::buildFromCounts(const std::vector<std::pair<std::string
         TreeNode* a = pq.extractMin();
         TreeNode* b = pq.extractMin();
 
-        TreeNode* parent = new TreeNode(a, b);
+        TreeNode* parent = tree.arena_.make(a, b);
 
         pq.insert(parent);
     }
 
-    // grab the root
-    tree.root_ = pq.extractMin();
+    // the last one left is the root
+    return pq.extractMin();
+}
+
 
-    return tree;
+TreeNode* HuffmanTree::mergeWithTwoQueues(HuffmanTree& tree, std::vector<TreeNode*> leaves) {
+    // sort the leaves into the order the priority queue would hand them out (MIN first)
+    std::sort(leaves.begin(), leaves.end(), [](const TreeNode* a, const TreeNode* b) {
+        return PriorityQueue::higherPriority(b, a);
+    });
+
+    // a parent always outweighs both of its children, so parents come out of the merge loop
+    // already in MIN-first order too (equal-weight parents included - their key words come out
+    // descending, just like the queue's tie-break). so a plain FIFO holds them, and the next
+    // minimum is always at the front of one of the two queues.
+    std::vector<TreeNode*> parents;
+    parents.reserve(leaves.size() - 1);
+    std::size_t nextLeaf = 0;
+    std::size_t nextParent = 0;
+
+    auto extractMin = [&]() {
+        const bool leafIsMin = nextLeaf < leaves.size() &&
+            (nextParent == parents.size() || PriorityQueue::higherPriority(parents[nextParent], leaves[nextLeaf]));
+        return leafIsMin ? leaves[nextLeaf++] : parents[nextParent++];
+    };
+
+    // every merge takes two nodes out and puts one back, so it takes (leaves - 1) of them
+    for (std::size_t merges = 1; merges < leaves.size(); ++merges) {
+        TreeNode* a = extractMin();
+        TreeNode* b = extractMin();
+        parents.push_back(tree.arena_.make(a, b));
+    }
+
+    // the last parent made is the root
+    return parents.back();
 }
 
 
-HuffmanTree::~HuffmanTree() {
-    destroy(root_);
+HuffmanTree::HuffmanTree(HuffmanTree&& other) noexcept
+    : root_(std::exchange(other.root_, nullptr)), arena_(std::move(other.arena_)),
+      codebook_(std::move(other.codebook_)), codesFit_(other.codesFit_), canonical_(other.canonical_) {}
+
+
+HuffmanTree& HuffmanTree::operator=(HuffmanTree&& other) noexcept {
+    // moving a tree onto itself would clear root_ first and lose the tree
+    if (this == &other)
+        return *this;
+
+    root_ = std::exchange(other.root_, nullptr);
+    arena_ = std::move(other.arena_);
+    codebook_ = std::move(other.codebook_);
+    codesFit_ = other.codesFit_;
+    canonical_ = other.canonical_;
+    return *this;
 }
 
 
@@ -62,12 +122,49 @@ void HuffmanTree::assignCodes(std::vector<std::pair<std::string, std::string>>&
         return;
     }
 
+    // canonical codes come straight out of the codebook
+    if (canonical_) {
+        out.reserve(codebook_.size());
+        for (std::size_t i = 0; i < codebook_.size(); ++i) {
+            const PackedCode& code = codebook_.code(i);
+            std::string bits;
+            for (int b = code.length - 1; b >= 0; --b)
+                bits += static_cast<char>('0' + ((code.bits >> b) & 1));
+            out.emplace_back(codebook_.word(i), std::move(bits));
+        }
+        return;
+    }
+
     // otherwise, we got work to do
     std::string prefix;
     assignCodesDFS(root_, prefix, out);
 }
 
 
+bool HuffmanTree::makeCanonical() {
+    // codes too long to pack can't be renumbered (they stay as tree codes)
+    if (!codesFit_)
+        return false;
+
+    // nothing to renumber
+    if (root_ == nullptr || canonical_)
+        return true;
+
+    // the tree decides how long each code is; the canonical order decides the codes themselves
+    std::vector<std::pair<const TreeNode*, unsigned>> leaves;
+    collectLeaves(root_, 0, leaves);
+
+    std::vector<std::pair<std::string, unsigned>> lengths;
+    lengths.reserve(leaves.size());
+    for (const auto& [leaf, depth] : leaves)
+        lengths.emplace_back(leaf->word, depth == 0 ? 1 : depth); // a lone root still gets one bit
+
+    codebook_ = Codebook::canonical(std::move(lengths));
+    canonical_ = true;
+    return true;
+}
+
+
 error_type HuffmanTree::writeHeader(std::ostream& os) const {
     // check if the state of the object is fine
     if (!os.good())
@@ -77,9 +174,31 @@ error_type HuffmanTree::writeHeader(std::ostream& os) const {
     if (root_ == nullptr)
         return NO_ERROR;
 
+    // canonical codes only need each word's length, grouped by length
+    if (canonical_) {
+        const std::size_t words = codebook_.size();
+        os << "canonical " << words << ' ' << static_cast<unsigned>(codebook_.code(words - 1).length) << '\n';
+
+        // the codebook is already in canonical order, so every length's words come in one run
+        for (std::size_t first = 0; first < words; ) {
+            const std::uint8_t length = codebook_.code(first).length;
+            std::size_t last = first;
+            while (last < words && codebook_.code(last).length == length)
+                ++last;
+
+            os << static_cast<unsigned>(length) << ' ' << (last - first);
+            for (std::size_t i = first; i < last; ++i)
+                os << ' ' << codebook_.word(i);
+            os << '\n';
+
+            first = last;
+        }
+    }
     // otherwise, do the actual work
-    std::string prefix;
-    writeHeaderPreorder(root_, os, prefix);
+    else {
+        std::string prefix;
+        writeHeaderPreorder(root_, os, prefix);
+    }
 
     // if something happened, flag it
     if (os.fail())
@@ -89,58 +208,244 @@ error_type HuffmanTree::writeHeader(std::ostream& os) const {
 }
 
 
-error_type HuffmanTree::encode(const std::vector<std::string>& tokens, std::ostream& os_bits, int wrap_cols) const {
+error_type HuffmanTree::encode(const std::vector<std::string>& tokens, std::ostream& os_bits, int wrap_cols,
+                               CodeFormat format, SyncIndex* index) const {
     // check if the state of the object is fine
     if (!os_bits.good())
         return UNABLE_TO_OPEN_FILE_FOR_WRITING;
 
-    // check if our tree is already empty
-    if (root_ == nullptr)
+    // check if our tree is already empty (a binary file still gets its header)
+    if (root_ == nullptr && format == CodeFormat::Ascii)
         return NO_ERROR;
 
-    // then, get the words and codes and put them into a vector
-    std::vector<std::pair<std::string, std::string>> codeVector;
-    assignCodes(codeVector);
+    // the encoder does the actual work, one token at a time
+    Encoder encoder(*this, os_bits, wrap_cols, format);
+    encoder.trackSyncPoints(index);
+    for (const auto& token : tokens) {
+        if (error_type status = encoder.put(token); status != NO_ERROR)
+            return status;
+    }
 
-    // put the words and codes into a map
-    std::map<std::string, std::string> codes;
-    for (const auto& [word, code] : codeVector)
-        codes[word] = code;
+    return encoder.finish();
+}
 
-    int col = 0;
 
-    // finally, put the tokens into the file
-    for (const auto& token : tokens) {
-        // find the token
-        auto iterator = codes.find(token);
-        // if it didn't work, then throw an error
-        if (iterator == codes.end()) {
-            std::cerr << "Error: Token '" << token << "' not found in codebook\n";
-            return FAILED_TO_WRITE_FILE;
+error_type HuffmanTree::encode(const std::vector<std::uint32_t>& ids, const Vocabulary& vocab,
+                               std::ostream& os_bits, int wrap_cols, CodeFormat format, SyncIndex* index) const {
+    // check if the state of the object is fine
+    if (!os_bits.good())
+        return UNABLE_TO_OPEN_FILE_FOR_WRITING;
+
+    // check if our tree is already empty (a binary file still gets its header)
+    if (root_ == nullptr && format == CodeFormat::Ascii)
+        return NO_ERROR;
+
+    // same as above, but every token is an array index instead of a map lookup
+    Encoder encoder(*this, vocab, os_bits, wrap_cols, format);
+    encoder.trackSyncPoints(index);
+    for (const std::uint32_t id : ids) {
+        if (error_type status = encoder.putId(id); status != NO_ERROR)
+            return status;
+    }
+
+    return encoder.finish();
+}
+
+
+namespace {
+    // tokens per chunk below which another thread isn't worth it
+    constexpr std::size_t kMinChunkTokens = 1 << 15;
+
+    // Writes one chunk's bits straight into the shared output buffer, starting at any bit offset.
+    // Every byte it covers completely belongs to it alone; the (at most two) bytes it shares with the chunks on
+    // either side are handed back in edges() instead, to be OR-ed in once every chunk is done.
+    class ChunkBitWriter {
+    public:
+        ChunkBitWriter(unsigned char* buffer, const std::uint64_t startBit)
+            : buffer_(buffer), next_(startBit / 8), accBits_(static_cast<unsigned>(startBit % 8)),
+              sharedFirst_(startBit % 8 != 0) {}
+
+        void put(const std::uint64_t bits, const unsigned length) {
+            // same accumulator as BitWriter::put, spilling a byte at a time
+            acc_ = (acc_ << length) | bits;   // length <= 56 here (see encodeChunks), so nothing falls off the top
+            accBits_ += length;
+            while (accBits_ >= 8) {
+                accBits_ -= 8;
+                emit(static_cast<unsigned char>(acc_ >> accBits_));
+            }
+        }
+
+        // flush the last partial byte; returns the shared bytes as (index, bits) pairs
+        std::vector<std::pair<std::uint64_t, unsigned char>> edges() {
+            if (accBits_ > 0)
+                edges_.emplace_back(next_, static_cast<unsigned char>(acc_ << (8 - accBits_)));
+            return std::move(edges_);
+        }
+
+    private:
+        unsigned char* buffer_;
+        std::uint64_t next_;     // index of the next byte to emit
+        std::uint64_t acc_ = 0;  // the low accBits_ bits are pending (leading zeros stand in for the previous chunk)
+        unsigned accBits_;
+        bool sharedFirst_;       // the first byte starts mid-way, so the previous chunk owns part of it
+        std::vector<std::pair<std::uint64_t, unsigned char>> edges_;
+
+        void emit(const unsigned char byte) {
+            if (sharedFirst_) {
+                edges_.emplace_back(next_++, byte);
+                sharedFirst_ = false;
+            }
+            else
+                buffer_[next_++] = byte;
         }
+    };
+}
+
+
+error_type HuffmanTree::encodeParallel(const std::vector<std::string>& tokens, std::ostream& os_bits,
+                                       const unsigned threads, int wrap_cols, CodeFormat format,
+                                       SyncIndex* index) const {
+    return encodeChunks(tokens.size(), [&](const std::size_t i) { return codebook_.find(tokens[i]); },
+                        os_bits, threads, wrap_cols, format, index);
+}
+
+
+error_type HuffmanTree::encodeParallel(const std::vector<std::uint32_t>& ids, const Vocabulary& vocab,
+                                       std::ostream& os_bits, const unsigned threads, int wrap_cols,
+                                       CodeFormat format, SyncIndex* index) const {
+    const std::vector<PackedCode> codesById = codebook_.indexedBy(vocab);
+    return encodeChunks(ids.size(), [&](const std::size_t i) -> const PackedCode* {
+                            const std::uint32_t id = ids[i];
+                            return id < codesById.size() && codesById[id].length != 0 ? &codesById[id] : nullptr;
+                        },
+                        os_bits, threads, wrap_cols, format, index);
+}
+
+
+template <typename CodeOf>
+error_type HuffmanTree::encodeChunks(const std::size_t tokenCount, CodeOf code, std::ostream& os_bits,
+                                     const unsigned threads, const int wrap_cols, const CodeFormat format,
+                                     SyncIndex* index) const {
+    // check if the state of the object is fine
+    if (!os_bits.good())
+        return UNABLE_TO_OPEN_FILE_FOR_WRITING;
 
-        // otherwise, we have found the token
-        // get the code of that token
-        const std::string& code = iterator->second;
+    // same as encode(): an empty tree writes nothing (or just the header)
+    if (root_ == nullptr && format == CodeFormat::Ascii)
+        return NO_ERROR;
 
-        // then, put it into the file
-        for (char c : code) {
-            os_bits << c;
-            col++;
+    if (!codesFit_) {
+        std::cerr << "Error: Huffman codes are longer than " << Codebook::kMaxCodeLength << " bits\n";
+        return FAILED_TO_WRITE_FILE;
+    }
 
-            // check to wrap the edge
-            if (col >= wrap_cols) {
-                os_bits << '\n';
-                col = 0;
+    // split the tokens into one chunk per thread (fewer if there aren't many tokens)
+    const std::size_t chunks = std::clamp<std::size_t>(resolveThreadCount(threads), 1,
+                                                       std::max<std::size_t>(tokenCount / kMinChunkTokens, 1));
+    auto chunkBegin = [&](const std::size_t c) { return tokenCount * c / chunks; };
+
+    // pass 1: how many bits each chunk comes to (and whether every token has a code)
+    std::vector<std::uint64_t> startBit(chunks + 1, 0);
+    std::vector<std::size_t> missing(chunks, tokenCount);
+    runOnThreads(chunks, [&](const std::size_t c) {
+        std::uint64_t bits = 0;
+        for (std::size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i) {
+            const PackedCode* packed = code(i);
+            if (packed == nullptr) {
+                missing[c] = i;
+                return;
             }
+            bits += packed->length;
         }
+        startBit[c + 1] = bits;
+    });
+
+    for (std::size_t c = 0; c < chunks; ++c) {
+        if (missing[c] != tokenCount) {
+            std::cerr << "Error: Token #" << missing[c] << " not found in codebook\n";
+            return FAILED_TO_WRITE_FILE;
+        }
+    }
+
+    // ...and the prefix sum turns those sizes into where each chunk starts
+    for (std::size_t c = 0; c < chunks; ++c)
+        startBit[c + 1] += startBit[c];
+    const std::uint64_t totalBits = startBit[chunks];
+
+    std::vector<unsigned char> out;
+
+    // each chunk notes its own sync points; they're strung together in order afterwards
+    std::vector<SyncIndex> chunkIndex(index != nullptr ? chunks : 0, SyncIndex(index != nullptr ? index->interval() : 1));
+    auto noteToken = [&](const std::size_t c, const std::size_t i, const std::uint64_t bit) {
+        if (index != nullptr)
+            chunkIndex[c].beforeToken(i, bit);
+    };
+
+    if (format == CodeFormat::Binary) {
+        // pass 2: every chunk packs its bits into its own stretch of the buffer
+        out.assign(static_cast<std::size_t>((totalBits + 7) / 8), 0);
+        std::vector<std::vector<std::pair<std::uint64_t, unsigned char>>> edges(chunks);
+        runOnThreads(chunks, [&](const std::size_t c) {
+            ChunkBitWriter writer(out.data(), startBit[c]);
+            std::uint64_t bit = startBit[c];
+            for (std::size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i) {
+                const PackedCode& packed = *code(i);
+                noteToken(c, i, bit);
+                bit += packed.length;
+                // split codes too long to shift in whole (the accumulator may already hold 7 bits)
+                if (packed.length > 56) {
+                    writer.put(packed.bits >> 32, packed.length - 32u);
+                    writer.put(packed.bits & 0xFFFFFFFFu, 32);
+                }
+                else
+                    writer.put(packed.bits, packed.length);
+            }
+            edges[c] = writer.edges();
+        });
+
+        // patch in the bytes neighbouring chunks share
+        for (const auto& chunkEdges : edges)
+            for (const auto& [index, bits] : chunkEdges)
+                out[index] |= bits;
+
+        const auto padding = static_cast<std::uint8_t>(out.size() * 8 - totalBits);
+        if (error_type status = writeCodeFileHeader(os_bits, CodeFileHeader{totalBits, padding}); status != NO_ERROR)
+            return status;
+    }
+    else {
+        // ascii: bit b lands at b + (line breaks before it), so every character has exactly one owner
+        const std::uint64_t wrap = wrap_cols > 0 ? static_cast<std::uint64_t>(wrap_cols) : 1;
+        const std::uint64_t lines = (totalBits + wrap - 1) / wrap;
+        out.assign(static_cast<std::size_t>(totalBits + lines), '\n');
+
+        runOnThreads(chunks, [&](const std::size_t c) {
+            std::uint64_t bit = startBit[c];
+            std::uint64_t column = bit % wrap;
+            unsigned char* dst = out.data() + bit + bit / wrap;
+
+            for (std::size_t i = chunkBegin(c); i < chunkBegin(c + 1); ++i) {
+                const PackedCode& packed = *code(i);
+                noteToken(c, i, bit);
+                bit += packed.length;
+                for (int b = packed.length - 1; b >= 0; --b) {
+                    *dst++ = static_cast<unsigned char>('0' + ((packed.bits >> b) & 1));
+                    // the '\n' is already there; just step over it
+                    if (++column == wrap) {
+                        column = 0;
+                        ++dst;
+                    }
+                }
+            }
+        });
     }
 
-    // put an extra line at the end if necessary
-    if (col > 0)
-        os_bits << '\n';
+    if (index != nullptr) {
+        for (const SyncIndex& part : chunkIndex)
+            index->append(part);
+        index->finish(tokenCount, totalBits);
+    }
 
-    // one last error check
+    os_bits.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
     if (os_bits.fail())
         return FAILED_TO_WRITE_FILE;
 
@@ -148,15 +453,298 @@ error_type HuffmanTree::encode(const std::vector<std::string>& tokens, std::ostr
 }
 
 
-void HuffmanTree::destroy(TreeNode* n) noexcept {
-    // if there's nothing to destroy, then don't destroy
+HuffmanTree::Encoder::Encoder(const HuffmanTree& tree, std::ostream& os_bits, int wrap_cols, CodeFormat format)
+    : tree_(tree), os_bits_(os_bits) {
+    // the codebook already exists (it was built with the tree), so the only setup is the writer
+    if (format == CodeFormat::Binary)
+        bitWriter_.emplace(os_bits_);
+    else
+        textWriter_.emplace(os_bits_, wrap_cols);
+}
+
+
+HuffmanTree::Encoder::Encoder(const HuffmanTree& tree, const Vocabulary& vocab, std::ostream& os_bits, int wrap_cols,
+                              CodeFormat format)
+    : Encoder(tree, os_bits, wrap_cols, format) {
+    // line the codes up by word id
+    codesById_ = tree.codebook().indexedBy(vocab);
+}
+
+
+error_type HuffmanTree::Encoder::put(const std::string_view token) {
+    // find the token
+    const PackedCode* code = tree_.codebook().find(token);
+    // if it didn't work, then throw an error
+    if (code == nullptr) {
+        std::cerr << "Error: Token '" << token << "' not found in codebook\n";
+        return FAILED_TO_WRITE_FILE;
+    }
+
+    // otherwise, we have found the token, so write its code
+    if (syncIndex_ != nullptr)
+        syncIndex_->beforeToken(tokens_, bits_);
+    tokens_++;
+    return writeCode(*code);
+}
+
+
+error_type HuffmanTree::Encoder::putId(const std::uint32_t id) {
+    // every code has at least one bit, so an empty one means the word never made it into the tree
+    if (id >= codesById_.size() || codesById_[id].length == 0) {
+        std::cerr << "Error: Token id " << id << " not found in codebook\n";
+        return FAILED_TO_WRITE_FILE;
+    }
+
+    if (syncIndex_ != nullptr)
+        syncIndex_->beforeToken(tokens_, bits_);
+    tokens_++;
+    return writeCode(codesById_[id]);
+}
+
+
+error_type HuffmanTree::Encoder::writeCode(const PackedCode& code) {
+    // a leaf too deep to pack never got a code
+    if (!tree_.codesFit()) {
+        std::cerr << "Error: Huffman codes are longer than " << Codebook::kMaxCodeLength << " bits\n";
+        return FAILED_TO_WRITE_FILE;
+    }
+
+    bits_ += code.length;
+
+    // binary: hand the whole code to the bit packer
+    if (bitWriter_) {
+        bitWriter_->put(code.bits, code.length);
+        return NO_ERROR;
+    }
+
+    // ascii: the text writer spells it out and breaks the lines
+    textWriter_->put(code.bits, code.length);
+    return NO_ERROR;
+}
+
+
+error_type HuffmanTree::Encoder::finish() {
+    if (syncIndex_ != nullptr)
+        syncIndex_->finish(tokens_, bits_);
+
+    // binary: the last byte gets padded and the header filled in
+    if (bitWriter_)
+        return bitWriter_->finish();
+
+    // ascii: end the last line and write out whatever is still buffered
+    return textWriter_->finish();
+}
+
+
+void HuffmanTree::buildCodebook() {
+    // start over, in case this tree is being rebuilt
+    codebook_ = Codebook();
+    codesFit_ = true;
+
+    // a tree with a single leaf still gets a one-bit code ("0"), same as assignCodes
+    if (root_ != nullptr && root_->isLeaf())
+        codebook_.add(root_->word, PackedCode{0, 1});
+    else
+        codebookDFS(root_, 0, 0);
+}
+
+
+bool HuffmanTree::limitCodeLengths(const unsigned maxLength) {
+    // nothing to limit
+    if (root_ == nullptr)
+        return true;
+
+    // every leaf, least frequent first (ties by word, so the result doesn't depend on the tree's shape)
+    std::vector<std::pair<const TreeNode*, unsigned>> leaves;
+    collectLeaves(root_, 0, leaves);
+    std::sort(leaves.begin(), leaves.end(), [](const auto& a, const auto& b) {
+        return a.first->count != b.first->count ? a.first->count < b.first->count : a.first->word < b.first->word;
+    });
+
+    // maxLength bits can only tell 2^maxLength words apart
+    if (maxLength == 0 || maxLength > Codebook::kMaxCodeLength ||
+        (maxLength < 63 && leaves.size() > (std::size_t{1} << maxLength)))
+        return false;
+
+    std::vector<std::size_t> counts;
+    counts.reserve(leaves.size());
+    for (const auto& [leaf, depth] : leaves)
+        counts.push_back(leaf->count);
+
+    const std::vector<unsigned> lengths = packageMergeLengths(counts, maxLength);
+
+    std::vector<std::pair<std::string, unsigned>> wordLengths;
+    wordLengths.reserve(leaves.size());
+    for (std::size_t i = 0; i < leaves.size(); ++i)
+        wordLengths.emplace_back(leaves[i].first->word, lengths[i]);
+
+    codebook_ = Codebook::canonical(std::move(wordLengths));
+    codesFit_ = true;
+    canonical_ = true;
+    return true;
+}
+
+
+std::vector<unsigned> HuffmanTree::packageMergeLengths(const std::vector<std::size_t>& sortedCounts, const unsigned maxLength) {
+    const std::size_t n = sortedCounts.size();
+    std::vector<unsigned> lengths(n, 1);
+    if (n <= 2)
+        return lengths;
+
+    // Package-merge: level 0 is the leaves (ascending weight). Every next level pairs up the previous level's items
+    // into packages and merges them back into the leaves. Picking the 2n - 2 lightest items on the last level
+    // picks an optimal code: a leaf's code length is the number of levels its leaf gets picked on.
+    // Only whether each item is a package is kept per level; since leaves and packages each stay in weight order,
+    // the picked items on a level are always a prefix, and its leaves are always the lightest ones.
+    std::vector<std::vector<bool>> isPackage(maxLength);
+    std::vector<std::uint64_t> previous(sortedCounts.begin(), sortedCounts.end());
+    isPackage[0].assign(n, false);
+
+    for (unsigned level = 1; level < maxLength; ++level) {
+        std::vector<std::uint64_t> merged;
+        merged.reserve(n + previous.size() / 2);
+        std::vector<bool>& packages = isPackage[level];
+        packages.reserve(n + previous.size() / 2);
+
+        std::size_t leaf = 0, pair = 0;
+        while (leaf < n || pair + 1 < previous.size()) {
+            const bool havePackage = pair + 1 < previous.size();
+            const std::uint64_t packageWeight = havePackage ? previous[pair] + previous[pair + 1] : 0;
+
+            // on a tie, take the leaf
+            if (leaf < n && (!havePackage || sortedCounts[leaf] <= packageWeight)) {
+                merged.push_back(sortedCounts[leaf++]);
+                packages.push_back(false);
+            }
+            else {
+                merged.push_back(packageWeight);
+                packages.push_back(true);
+                pair += 2;
+            }
+        }
+
+        previous = std::move(merged);
+    }
+
+    // walk back down: each picked package picks two items on the level below it
+    std::fill(lengths.begin(), lengths.end(), 0);
+    std::size_t picked = 2 * n - 2;
+    for (unsigned level = maxLength; level-- > 0; ) {
+        std::size_t packagesPicked = 0;
+        for (std::size_t i = 0; i < picked; ++i)
+            packagesPicked += isPackage[level][i];
+
+        // the leaves picked here are the lightest (picked - packagesPicked)
+        for (std::size_t i = 0; i < picked - packagesPicked; ++i)
+            lengths[i]++;
+
+        picked = 2 * packagesPicked;
+    }
+
+    return lengths;
+}
+
+
+EncodingStats HuffmanTree::encodingStats() const {
+    std::vector<std::pair<const TreeNode*, unsigned>> leaves;
+    collectLeaves(root_, 0, leaves);
+
+    // each word costs its code's length every time it shows up
+    EncodingStats stats;
+    for (const auto& [leaf, depth] : leaves) {
+        const PackedCode* code = codebook_.find(leaf->word);
+        const unsigned length = code != nullptr ? code->length : (depth == 0 ? 1 : depth); // too long to pack
+        stats.totalTokens += leaf->count;
+        stats.totalBits += static_cast<std::uint64_t>(leaf->count) * length;
+    }
+
+    if (stats.totalTokens == 0)
+        return stats;
+
+    // entropy: -sum(p * log2 p) over the words, where p is the share of the tokens each word makes up
+    const auto total = static_cast<double>(stats.totalTokens);
+    for (const auto& [leaf, depth] : leaves) {
+        const double p = static_cast<double>(leaf->count) / total;
+        if (p > 0.0)
+            stats.entropyBits -= p * std::log2(p);
+    }
+
+    stats.averageBits = static_cast<double>(stats.totalBits) / total;
+    stats.gapBits = stats.averageBits - stats.entropyBits;
+    return stats;
+}
+
+
+std::uint64_t HuffmanTree::treeEncodedBits() const {
+    std::vector<std::pair<const TreeNode*, unsigned>> leaves;
+    collectLeaves(root_, 0, leaves);
+
+    std::uint64_t bits = 0;
+    for (const auto& [leaf, depth] : leaves)
+        bits += static_cast<std::uint64_t>(leaf->count) * (depth == 0 ? 1 : depth);
+
+    return bits;
+}
+
+
+unsigned HuffmanTree::longestCode() const {
+    // codes too long to pack aren't in the codebook, so they can only come from the tree
+    if (!codesFit_)
+        return treeHeight();
+
+    unsigned longest = 0;
+    for (std::size_t i = 0; i < codebook_.size(); ++i)
+        longest = std::max<unsigned>(longest, codebook_.code(i).length);
+
+    return longest;
+}
+
+
+unsigned HuffmanTree::treeHeight() const {
+    std::vector<std::pair<const TreeNode*, unsigned>> leaves;
+    collectLeaves(root_, 0, leaves);
+
+    unsigned height = 0;
+    for (const auto& [leaf, depth] : leaves)
+        height = std::max(height, depth == 0 ? 1u : depth);
+
+    return height;
+}
+
+
+void HuffmanTree::collectLeaves(const TreeNode* n, const unsigned depth,
+                                std::vector<std::pair<const TreeNode*, unsigned>>& out) {
+    // base case
+    if (n == nullptr)
+        return;
+
+    if (n->isLeaf()) {
+        out.emplace_back(n, depth);
+        return;
+    }
+
+    collectLeaves(n->left, depth + 1, out);
+    collectLeaves(n->right, depth + 1, out);
+}
+
+
+void HuffmanTree::codebookDFS(const TreeNode* n, const std::uint64_t bits, const unsigned depth) {
+    // base case
     if (n == nullptr)
         return;
 
-    // otherwise, CONTINUE THE DESTRUCTION!
-    destroy(n->left);
-    destroy(n->right);
-    delete n;
+    // if we've reached a leaf, its path from the root is its code
+    if (n->isLeaf()) {
+        if (depth > Codebook::kMaxCodeLength)
+            codesFit_ = false;
+        else
+            codebook_.add(n->word, PackedCode{bits, static_cast<std::uint8_t>(depth)});
+        return;
+    }
+
+    // otherwise, go left (append a 0) and then right (append a 1)
+    codebookDFS(n->left, bits << 1, depth + 1);
+    codebookDFS(n->right, (bits << 1) | 1, depth + 1);
 }
 
 
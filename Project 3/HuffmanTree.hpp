@@ -6,38 +6,175 @@
 #define PROJECT_3_HUFFMANTREE_HPP
 
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
 #include <utility>
 #include <iostream>
+#include <optional>
 #include "TreeNode.hpp"
+#include "NodeArena.hpp"
+#include "Codebook.hpp"
+#include "BitWriter.hpp"
+#include "OutputBuffer.hpp"
+#include "SyncIndex.hpp"
+#include "Vocabulary.hpp"
 #include "utils.hpp"
 
+// How buildFromCounts merges nodes. Both give the exact same tree.
+enum class HuffmanBuild {
+    PriorityQueue, // repeatedly extract the two minimums from a PriorityQueue - O(V log V)
+    TwoQueue,      // sort the leaves once, then merge from two FIFO queues - O(V) after the sort
+};
+
+// What encode() writes to the .code stream.
+enum class CodeFormat {
+    Ascii,  // one '0'/'1' character per bit, wrapped into lines
+    Binary, // a CodeFileHeader, then the bits packed 8 to a byte (the stream must be binary and seekable)
+};
+
+// Size of the encoded token stream, worked out from the counts and code lengths alone (no need to look at the output).
+struct EncodingStats {
+    std::uint64_t totalTokens = 0;
+    std::uint64_t totalBits = 0;   // sum of count * code length
+    double averageBits = 0.0;      // bits per token
+    double entropyBits = 0.0;      // Shannon entropy of the word frequencies, in bits per token (the best any code can average)
+    double gapBits = 0.0;          // averageBits - entropyBits
+};
+
 class HuffmanTree {
 public:
     // Build from BST output (lexicographic vector of (word, count)).
-    static HuffmanTree buildFromCounts(const std::vector<std::pair<std::string, int>>& counts);
+    static HuffmanTree buildFromCounts(const std::vector<std::pair<std::string, int>>& counts,
+                                       HuffmanBuild method = HuffmanBuild::PriorityQueue);
 
     HuffmanTree() = default;
-    ~HuffmanTree();
+    ~HuffmanTree() = default; // arena_ frees every node at once
+
+    // the tree owns its nodes, so it can be moved but not copied
+    HuffmanTree(const HuffmanTree&) = delete;
+    HuffmanTree& operator=(const HuffmanTree&) = delete;
+    HuffmanTree(HuffmanTree&& other) noexcept;
+    HuffmanTree& operator=(HuffmanTree&& other) noexcept;
+
+    // Switch to canonical codes: every word keeps its code length (so the encoded size doesn't change),
+    // but the codes themselves are renumbered in (length, word) order - see Codebook::canonical.
+    // Afterwards encode() uses the new codes and writeHeader() writes the compact lengths-only header.
+    // Returns false, changing nothing, if the tree's codes are too long to pack (see codesFit()).
+    bool makeCanonical();
+    [[nodiscard]] bool isCanonical() const noexcept { return canonical_; }
+
+    // Cap every code at maxLength bits (1..Codebook::kMaxCodeLength): the lengths are recomputed with package-merge,
+    // which gives the smallest encoded size any prefix code within the cap can reach, and then renumbered
+    // canonically (the codes no longer follow the tree's paths). Returns false, changing nothing,
+    // if maxLength is too short to give every word its own code (2^maxLength < distinct words).
+    bool limitCodeLengths(unsigned maxLength);
+
+    // Total size of the encoded tokens in bits (sum of count * code length): with the codes in use now,
+    // and with the plain Huffman tree's codes. limitCodeLengths() can only make the first one bigger.
+    [[nodiscard]] std::uint64_t encodedBits() const { return encodingStats().totalBits; }
+    [[nodiscard]] std::uint64_t treeEncodedBits() const;
+
+    // encodedBits() along with the per-token average and how close it gets to the entropy.
+    [[nodiscard]] EncodingStats encodingStats() const;
+
+    // Length of the longest code in use / of the longest root-to-leaf path in the tree.
+    [[nodiscard]] unsigned longestCode() const;
+    [[nodiscard]] unsigned treeHeight() const;
 
     // Build a vector of (word, code) pairs by traversing the Huffman tree
-    // (left=0, right=1; visit left before right).
+    // (left=0, right=1; visit left before right). Once canonical, the canonical codes in canonical order.
     void assignCodes(std::vector<std::pair<std::string, std::string>>& out) const;
 
+    // The same codes packed into integers, built once along with the tree (same order as assignCodes).
+    [[nodiscard]] const Codebook& codebook() const noexcept { return codebook_; }
+
+    // False if some leaf sits deeper than Codebook::kMaxCodeLength, so its code couldn't be packed.
+    [[nodiscard]] bool codesFit() const noexcept { return codesFit_; }
+
     // Header writer (pre-order over leaves; "word<space>code"; newline at end).
+    // Canonical trees write only the lengths instead:
+    //   "canonical <distinct words> <longest code length>"
+    //   then one line per code length in use: "<length> <number of words> <word> <word> ..." (words in canonical order)
     error_type writeHeader(std::ostream& os) const;
 
     // Encode a sequence of tokens using the codebook derived from this tree.
-    // Writes ASCII '0'/'1' and wraps lines to wrap_cols (80 by default).
-    error_type encode(const std::vector<std::string>& tokens, std::ostream& os_bits, int wrap_cols = 80) const;
+    // Writes ASCII '0'/'1' and wraps lines to wrap_cols (80 by default),
+    // or with CodeFormat::Binary, packed bits (wrap_cols is ignored).
+    // If 'index' is given, its sync points are filled in as the tokens go by.
+    error_type encode(const std::vector<std::string>& tokens, std::ostream& os_bits, int wrap_cols = 80,
+                      CodeFormat format = CodeFormat::Ascii, SyncIndex* index = nullptr) const;
+
+    // Same, for a token stream of word ids from 'vocab' (see Scanner::tokenizeIds).
+    error_type encode(const std::vector<std::uint32_t>& ids, const Vocabulary& vocab,
+                      std::ostream& os_bits, int wrap_cols = 80, CodeFormat format = CodeFormat::Ascii,
+                      SyncIndex* index = nullptr) const;
+
+    // Same output as encode(), byte for byte, produced on several threads (0 = one per core).
+    // Every code's length is known up front, so each chunk of tokens knows where its bits start
+    // (a prefix sum of the chunks' sizes) and is encoded straight into its place in one shared buffer;
+    // the only bytes two chunks share are patched in afterwards. The output is written with a single write.
+    error_type encodeParallel(const std::vector<std::string>& tokens, std::ostream& os_bits, unsigned threads,
+                              int wrap_cols = 80, CodeFormat format = CodeFormat::Ascii,
+                              SyncIndex* index = nullptr) const;
+    error_type encodeParallel(const std::vector<std::uint32_t>& ids, const Vocabulary& vocab, std::ostream& os_bits,
+                              unsigned threads, int wrap_cols = 80, CodeFormat format = CodeFormat::Ascii,
+                              SyncIndex* index = nullptr) const;
+
+    // Encodes tokens one at a time, for callers that never hold the whole token list.
+    // Builds the codebook once; put() each token in order, then finish(). Output matches encode().
+    class Encoder {
+    public:
+        Encoder(const HuffmanTree& tree, std::ostream& os_bits, int wrap_cols = 80,
+                CodeFormat format = CodeFormat::Ascii);
+
+        // Also index the codes by word id, so tokens can be passed to putId().
+        Encoder(const HuffmanTree& tree, const Vocabulary& vocab, std::ostream& os_bits, int wrap_cols = 80,
+                CodeFormat format = CodeFormat::Ascii);
+
+        // Record sync points in 'index' from here on (nullptr stops).
+        void trackSyncPoints(SyncIndex* index) noexcept { syncIndex_ = index; }
+
+        error_type put(std::string_view token);
+        error_type putId(std::uint32_t id);
+        error_type finish();
+
+        [[nodiscard]] std::uint64_t tokenCount() const noexcept { return tokens_; }
+        [[nodiscard]] std::uint64_t bitCount() const noexcept { return bits_; }
+
+    private:
+        const HuffmanTree& tree_;
+        std::vector<PackedCode> codesById_; // length 0 = id not in the tree
+        std::ostream& os_bits_;
+        std::optional<BitTextWriter> textWriter_; // spells the bits out and wraps the lines (Ascii)
+        std::optional<BitWriter> bitWriter_; // packs the bits (Binary)
+        SyncIndex* syncIndex_ = nullptr;
+        std::uint64_t tokens_ = 0;   // tokens written so far
+        std::uint64_t bits_ = 0;     // code bits written so far
+
+        error_type writeCode(const PackedCode& code);
+    };
 
 private:
-    TreeNode* root_ = nullptr; // owns the full Huffman tree
+    TreeNode* root_ = nullptr; // root of the full Huffman tree
+    NodeArena arena_;          // owns every node in it (leaves and merged parents)
+    Codebook codebook_;        // packed code of every leaf
+    bool codesFit_ = true;
+    bool canonical_ = false;   // codebook_ holds canonical codes instead of tree paths
 
     // helpers (decl only; defs in .cpp)
-    static void destroy(TreeNode* n) noexcept;
+    // encodeParallel() for any token source: code(i) is the i-th token's code (nullptr if it has none)
+    template <typename CodeOf>
+    error_type encodeChunks(std::size_t tokenCount, CodeOf code, std::ostream& os_bits, unsigned threads,
+                            int wrap_cols, CodeFormat format, SyncIndex* index) const;
+
+    static TreeNode* mergeWithPriorityQueue(HuffmanTree& tree, const std::vector<TreeNode*>& leaves);
+    static TreeNode* mergeWithTwoQueues(HuffmanTree& tree, std::vector<TreeNode*> leaves);
+    void buildCodebook();
+    void codebookDFS(const TreeNode* n, std::uint64_t bits, unsigned depth);
+    static std::vector<unsigned> packageMergeLengths(const std::vector<std::size_t>& sortedCounts, unsigned maxLength);
+    static void collectLeaves(const TreeNode* n, unsigned depth, std::vector<std::pair<const TreeNode*, unsigned>>& out);
     static void assignCodesDFS(const TreeNode* n, std::string& prefix, std::vector<std::pair<std::string, std::string>>& out);
     static void writeHeaderPreorder(const TreeNode* n, std::ostream& os, std::string& prefix);
 };
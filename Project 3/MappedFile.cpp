@@ -0,0 +1,122 @@
+#include "MappedFile.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+error_type MappedFile::open(const std::filesystem::path& path) {
+    close();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return UNABLE_TO_OPEN_FILE;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return UNABLE_TO_OPEN_FILE;
+    }
+
+    // windows refuses to map an empty file, so leave the view empty
+    if (fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return NO_ERROR;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+        return UNABLE_TO_OPEN_FILE;
+
+    // the view keeps the mapping alive, so the handle can go right away
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr)
+        return UNABLE_TO_OPEN_FILE;
+
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<std::size_t>(fileSize.QuadPart);
+    return NO_ERROR;
+}
+
+void MappedFile::close() noexcept {
+    if (data_ != nullptr)
+        UnmapViewOfFile(data_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#else
+
+error_type MappedFile::open(const std::filesystem::path& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return UNABLE_TO_OPEN_FILE;
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return UNABLE_TO_OPEN_FILE;
+    }
+
+    // mmap refuses a zero length, so leave the view empty
+    if (info.st_size == 0) {
+        ::close(fd);
+        return NO_ERROR;
+    }
+
+    const auto length = static_cast<std::size_t>(info.st_size);
+    void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping holds its own reference to the file
+    ::close(fd);
+    if (view == MAP_FAILED)
+        return UNABLE_TO_OPEN_FILE;
+
+    // we read front to back exactly once, so let the kernel read ahead aggressively
+    madvise(view, length, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const char*>(view);
+    size_ = length;
+    return NO_ERROR;
+}
+
+void MappedFile::close() noexcept {
+    if (data_ != nullptr)
+        munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#endif
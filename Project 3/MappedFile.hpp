@@ -0,0 +1,38 @@
+#ifndef PROJECT_3_MAPPEDFILE_HPP
+#define PROJECT_3_MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string_view>
+#include <filesystem>
+
+#include "utils.hpp"
+
+// Read-only memory mapping of a whole file.
+// The bytes stay valid until close() is called or the object is destroyed.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile(); // calls close()
+
+    // a mapping has exactly one owner
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Map 'path' into memory (unmapping anything mapped before).
+    // An empty file is not an error; it just maps to an empty view.
+    error_type open(const std::filesystem::path& path);
+    void close() noexcept;
+
+    [[nodiscard]] const char* data() const noexcept { return data_; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] std::string_view view() const noexcept { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+
+#endif //PROJECT_3_MAPPEDFILE_HPP
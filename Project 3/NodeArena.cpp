@@ -0,0 +1,48 @@
+#include "NodeArena.hpp"
+
+#include <algorithm>
+
+NodeArena::~NodeArena() {
+    clear();
+}
+
+NodeArena::NodeArena(NodeArena&& other) noexcept
+    : blocks_(std::move(other.blocks_)), nodeCount_(std::exchange(other.nodeCount_, 0)) {
+    other.blocks_.clear();
+}
+
+NodeArena& NodeArena::operator=(NodeArena&& other) noexcept {
+    if (this != &other) {
+        clear();
+        blocks_ = std::move(other.blocks_);
+        nodeCount_ = std::exchange(other.nodeCount_, 0);
+        other.blocks_.clear();
+    }
+    return *this;
+}
+
+void NodeArena::clear() noexcept {
+    // one straight pass over each block - no walking the tree, no per-node delete.
+    // (the destructor only has work to do for words too long to fit inside their std::string)
+    for (Block& block : blocks_) {
+        for (std::size_t i = 0; i < block.used; ++i)
+            block.nodes[i].~TreeNode();
+        ::operator delete(static_cast<void*>(block.nodes));
+    }
+
+    blocks_.clear();
+    nodeCount_ = 0;
+}
+
+void NodeArena::grow() {
+    // each block is twice as big as the one before it (up to a cap), so a big tree needs only a handful
+    const std::size_t capacity = blocks_.empty()
+        ? kFirstBlockNodes
+        : std::min(blocks_.back().capacity * 2, kMaxBlockNodes);
+
+    // make room in the block list first, so a failed push_back can't leak the block
+    if (blocks_.size() == blocks_.capacity())
+        blocks_.reserve(std::max<std::size_t>(16, blocks_.size() * 2));
+    auto* nodes = static_cast<TreeNode*>(::operator new(capacity * sizeof(TreeNode)));
+    blocks_.push_back({nodes, capacity, 0});
+}
@@ -0,0 +1,63 @@
+#ifndef PROJECT_3_NODEARENA_HPP
+#define PROJECT_3_NODEARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "TreeNode.hpp"
+
+
+// Bump allocator for TreeNodes.
+// Nodes are carved out of a few large blocks (each twice the size of the last) instead of one
+// 'new' apiece, so they sit next to each other in memory. Nothing is freed one node at a time:
+// clear() (or the destructor) sweeps the blocks front to back and releases them together.
+class NodeArena {
+public:
+    NodeArena() = default;
+    ~NodeArena(); // calls clear()
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+    NodeArena(NodeArena&& other) noexcept;
+    NodeArena& operator=(NodeArena&& other) noexcept;
+
+    // Construct a TreeNode in the arena (same arguments as TreeNode's constructors).
+    // The node lives until the arena is cleared or destroyed.
+    template <typename... Args>
+    TreeNode* make(Args&&... args) {
+        if (blocks_.empty() || blocks_.back().used == blocks_.back().capacity)
+            grow();
+
+        Block& block = blocks_.back();
+        TreeNode* node = ::new (static_cast<void*>(block.nodes + block.used)) TreeNode(std::forward<Args>(args)...);
+        block.used++;
+        nodeCount_++;
+        return node;
+    }
+
+    // Destroy every node and give the memory back.
+    void clear() noexcept;
+
+    [[nodiscard]] std::size_t nodeCount() const noexcept { return nodeCount_; }   // nodes made since the last clear()
+    [[nodiscard]] std::size_t blockCount() const noexcept { return blocks_.size(); } // heap allocations behind them
+
+private:
+    struct Block {
+        TreeNode* nodes;      // raw storage for 'capacity' nodes
+        std::size_t capacity;
+        std::size_t used;     // nodes[0 .. used) are constructed
+    };
+
+    static constexpr std::size_t kFirstBlockNodes = 64;
+    static constexpr std::size_t kMaxBlockNodes = 1 << 16;
+
+    std::vector<Block> blocks_;
+    std::size_t nodeCount_ = 0;
+
+    void grow();
+};
+
+
+#endif //PROJECT_3_NODEARENA_HPP
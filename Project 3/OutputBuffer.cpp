@@ -0,0 +1,75 @@
+#include "OutputBuffer.hpp"
+
+#include <array>
+
+namespace {
+    // the eight '0'/'1' characters of every byte, most significant bit first
+    constexpr std::array<std::array<char, 8>, 256> kByteText = [] {
+        std::array<std::array<char, 8>, 256> table{};
+        for (unsigned byte = 0; byte < 256; ++byte)
+            for (unsigned i = 0; i < 8; ++i)
+                table[byte][i] = static_cast<char>('0' + ((byte >> (7 - i)) & 1));
+        return table;
+    }();
+}
+
+
+OutputBuffer::OutputBuffer(std::ostream& os, const std::size_t capacity)
+    : os_(os), buffer_(std::max<std::size_t>(capacity, 64)) {}
+
+OutputBuffer::~OutputBuffer() {
+    drain();
+}
+
+void OutputBuffer::drain() {
+    if (used_ == 0)
+        return;
+    os_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+    used_ = 0;
+}
+
+error_type OutputBuffer::flush() {
+    drain();
+    os_.flush();
+    return os_.fail() ? FAILED_TO_WRITE_FILE : NO_ERROR;
+}
+
+void OutputBuffer::putRightAligned(std::uint64_t value, const unsigned width) {
+    // digits from the back of a scratch array, then the padding in front
+    char digits[20];
+    unsigned count = 0;
+    do {
+        digits[sizeof digits - ++count] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    for (unsigned pad = count; pad < width; ++pad)
+        put(' ');
+    write(digits + sizeof digits - count, count);
+}
+
+
+BitTextWriter::BitTextWriter(std::ostream& os, const int wrap_cols)
+    : out_(os), wrap_(wrap_cols > 0 ? static_cast<unsigned>(wrap_cols) : 1) {}
+
+void BitTextWriter::spell(const std::uint64_t bits, const unsigned length, char* text) {
+    // the odd bits at the front first, then whole bytes
+    const unsigned head = length % 8;
+    if (head != 0) {
+        std::memcpy(text, kByteText[(bits >> (length - head)) & 0xFF].data() + (8 - head), head);
+        text += head;
+    }
+    for (int shift = static_cast<int>(length - head) - 8; shift >= 0; shift -= 8) {
+        std::memcpy(text, kByteText[(bits >> shift) & 0xFF].data(), 8);
+        text += 8;
+    }
+}
+
+error_type BitTextWriter::finish() {
+    // put an extra line break at the end if necessary
+    if (column_ != 0) {
+        out_.put('\n');
+        column_ = 0;
+    }
+    return out_.flush();
+}
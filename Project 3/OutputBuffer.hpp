@@ -0,0 +1,103 @@
+#ifndef PROJECT_3_OUTPUTBUFFER_HPP
+#define PROJECT_3_OUTPUTBUFFER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "utils.hpp"
+
+
+// Collects text in one large block and hands it to the stream with a single write() whenever the block fills up,
+// instead of paying for operator<< (a sentry and a locale lookup) on every word or character.
+// Nothing reaches the stream before flush() (or the block filling up), so call flush() when done and check it.
+class OutputBuffer {
+public:
+    static constexpr std::size_t kDefaultCapacity = 1 << 16;
+
+    explicit OutputBuffer(std::ostream& os, std::size_t capacity = kDefaultCapacity);
+    ~OutputBuffer(); // writes out anything left, but can't report a failure; flush() can
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void put(const char c) {
+        if (used_ == buffer_.size())
+            drain();
+        buffer_[used_++] = c;
+    }
+
+    void write(const char* data, std::size_t size) {
+        // a short piece is copied; one bigger than the whole block goes straight through
+        if (size > buffer_.size() - used_) {
+            drain();
+            if (size >= buffer_.size()) {
+                os_.write(data, static_cast<std::streamsize>(size));
+                return;
+            }
+        }
+        std::memcpy(buffer_.data() + used_, data, size);
+        used_ += size;
+    }
+
+    void write(const std::string_view text) { write(text.data(), text.size()); }
+
+    // 'value' in decimal, padded on the left with spaces to 'width' characters (what std::setw does)
+    void putRightAligned(std::uint64_t value, unsigned width);
+
+    // Write out everything buffered so far and flush the stream.
+    error_type flush();
+
+private:
+    std::ostream& os_;
+    std::vector<char> buffer_;
+    std::size_t used_ = 0;
+
+    void drain();
+};
+
+
+// Writes code bits as '0'/'1' characters wrapped into lines of 'wrap_cols' columns, the ASCII .code format.
+// A code is spelled out eight bits at a time from a lookup table and copied into the buffer in slices that run
+// up to the end of the current line, so a line break costs one put('\n') rather than a column check per bit.
+class BitTextWriter {
+public:
+    BitTextWriter(std::ostream& os, int wrap_cols);
+
+    // Append the low 'length' bits of 'bits' (1 <= length <= 64), most significant first.
+    void put(const std::uint64_t bits, const unsigned length) {
+        char text[64];
+        spell(bits, length, text);
+
+        const char* next = text;
+        for (unsigned left = length; left > 0; ) {
+            const unsigned slice = std::min(left, wrap_ - column_);
+            out_.write(next, slice);
+            next += slice;
+            left -= slice;
+            column_ += slice;
+            if (column_ == wrap_) {
+                out_.put('\n');
+                column_ = 0;
+            }
+        }
+    }
+
+    // End an unfinished last line and write everything out. Call once, after the last put().
+    error_type finish();
+
+private:
+    OutputBuffer out_;
+    unsigned wrap_;
+    unsigned column_ = 0; // characters on the current line so far
+
+    // 'length' characters for the low 'length' bits of 'bits' into 'text'
+    static void spell(std::uint64_t bits, unsigned length, char* text);
+};
+
+
+#endif //PROJECT_3_OUTPUTBUFFER_HPP
@@ -0,0 +1,204 @@
+#ifndef PROJECT_3_PARALLEL_HPP
+#define PROJECT_3_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+
+// A thread count from the command line: 0 means "one per core"
+// (hardware_concurrency itself may say 0 if it can't tell).
+inline unsigned resolveThreadCount(const unsigned threads) {
+    return threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Work-stealing pool behind runWorkStealing(). Every worker has its own queue of jobs: it runs them from the front,
+// and one whose queue is empty takes a job from the back of someone else's. Jobs can add more jobs while they run
+// (runOnThreads() does, from inside a pool worker), so the pool is only done once nothing is queued or running.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(const std::size_t workers) : queues_(std::max<std::size_t>(workers, 1)) {}
+
+    [[nodiscard]] std::size_t workers() const noexcept { return queues_.size(); }
+
+    // The pool the calling thread is a worker of (nullptr outside one), and which worker it is.
+    static WorkStealingPool*& current() noexcept {
+        thread_local WorkStealingPool* pool = nullptr;
+        return pool;
+    }
+    static std::size_t& currentWorker() noexcept {
+        thread_local std::size_t worker = 0;
+        return worker;
+    }
+
+    // Queue 'job' on worker 'owner'. 'group' tags it, so whoever forked it can pick its own jobs back out.
+    void push(const std::size_t owner, std::function<void()> job, const void* group = nullptr, const bool front = false) {
+        unfinished_.fetch_add(1);
+        {
+            std::lock_guard lock(queues_[owner].mutex);
+            if (front)
+                queues_[owner].jobs.push_front(Job{std::move(job), group});
+            else
+                queues_[owner].jobs.push_back(Job{std::move(job), group});
+        }
+        queued_.fetch_add(1);
+        { std::lock_guard lock(wakeMutex_); }
+        wake_.notify_one();
+    }
+
+    // Run the workers on this thread and workers() - 1 new ones, until every job (and every job they add) is done.
+    void run() {
+        std::vector<std::thread> threads;
+        threads.reserve(workers() - 1);
+        for (std::size_t i = 0; i + 1 < workers(); ++i)
+            threads.emplace_back([this, i] { work(i); });
+        work(workers() - 1);
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    // Run the front job of worker 'self''s queue if it belongs to 'group'. Returns false if it doesn't.
+    bool runOwn(const std::size_t self, const void* group) {
+        std::optional<Job> job;
+        {
+            std::lock_guard lock(queues_[self].mutex);
+            if (!queues_[self].jobs.empty() && queues_[self].jobs.front().group == group) {
+                job = std::move(queues_[self].jobs.front());
+                queues_[self].jobs.pop_front();
+            }
+        }
+        if (!job)
+            return false;
+        queued_.fetch_sub(1);
+        finish(*job);
+        return true;
+    }
+
+private:
+    struct Job {
+        std::function<void()> run;
+        const void* group;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<Queue> queues_;
+    std::atomic<std::size_t> unfinished_{0}; // queued or running
+    std::atomic<std::size_t> queued_{0};
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;           // something was queued, or everything is done
+
+    std::optional<Job> take(const std::size_t self) {
+        {
+            std::lock_guard lock(queues_[self].mutex);
+            if (!queues_[self].jobs.empty()) {
+                Job job = std::move(queues_[self].jobs.front());
+                queues_[self].jobs.pop_front();
+                return job;
+            }
+        }
+
+        // own queue's empty: try everyone else's, starting with the next worker over
+        for (std::size_t v = 1; v < workers(); ++v) {
+            Queue& victim = queues_[(self + v) % workers()];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                Job job = std::move(victim.jobs.back());
+                victim.jobs.pop_back();
+                return job;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void finish(Job& job) {
+        job.run();
+        if (unfinished_.fetch_sub(1) == 1) {
+            { std::lock_guard lock(wakeMutex_); }
+            wake_.notify_all();
+        }
+    }
+
+    void work(const std::size_t self) {
+        current() = this;
+        currentWorker() = self;
+
+        while (true) {
+            if (std::optional<Job> job = take(self)) {
+                queued_.fetch_sub(1);
+                finish(*job);
+                continue;
+            }
+
+            // nothing to take: done if nothing is running either, otherwise wait for a running job to add some
+            std::unique_lock lock(wakeMutex_);
+            if (unfinished_.load() == 0)
+                break;
+            wake_.wait(lock, [&] { return queued_.load() != 0 || unfinished_.load() == 0; });
+        }
+
+        current() = nullptr;
+    }
+};
+
+// Run task(0) .. task(count - 1), each on its own thread (the last one on this thread).
+// Called from a WorkStealingPool worker, the tasks become jobs on that pool instead, so idle workers pick them up
+// and nothing runs on more threads than the pool has; this thread works through its own share while it waits.
+template <typename Task>
+void runOnThreads(const std::size_t count, Task task) {
+    if (WorkStealingPool* const pool = WorkStealingPool::current(); pool != nullptr && count > 1) {
+        const std::size_t self = WorkStealingPool::currentWorker();
+        std::atomic<std::size_t> left{count - 1};
+        const void* const group = &left;
+        for (std::size_t i = count - 1; i-- > 0; )
+            pool->push(self, [&task, &left, i] { task(i); left.fetch_sub(1); }, group, true);
+
+        task(count - 1);
+
+        // run whatever of ours nobody stole; wait for the rest
+        while (left.load() != 0) {
+            if (!pool->runOwn(self, group))
+                std::this_thread::yield();
+        }
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(count);
+    for (std::size_t i = 0; i + 1 < count; ++i)
+        workers.emplace_back(task, i);
+
+    if (count > 0)
+        task(count - 1);
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+// Run task(0) .. task(count - 1) on 'threads' workers (0 = one per core) that balance the load by stealing.
+// The tasks are dealt out round-robin in the order given; each worker runs its own from the front of its queue,
+// and one that runs dry takes a task from the back of someone else's. Put the biggest tasks first: they start first,
+// and nobody sits idle while tasks are still waiting anywhere. A task that calls runOnThreads() splits itself
+// across the same workers, so one huge task doesn't leave the others idle once the small ones are done.
+template <typename Task>
+void runWorkStealing(const std::size_t count, const unsigned threads, Task task) {
+    // every worker is kept even with fewer tasks than workers: the tasks may split themselves up
+    WorkStealingPool pool(resolveThreadCount(threads));
+    for (std::size_t i = 0; i < count; ++i)
+        pool.push(i % pool.workers(), [&task, i] { task(i); });
+    pool.run();
+}
+
+
+#endif //PROJECT_3_PARALLEL_HPP
@@ -5,8 +5,11 @@
 #include "PriorityQueue.hpp"
 #include <algorithm>
 
+// The std heap algorithms keep the "largest" element (the one that sorts last under the comparator)
+// at the front. With higherPriority as the comparator, that's exactly our MIN.
+
 PriorityQueue::PriorityQueue(std::vector<TreeNode *> nodes) : items_(std::move(nodes)) {
-    std::sort(items_.begin(), items_.end(), higherPriority);
+    std::make_heap(items_.begin(), items_.end(), higherPriority);
 }
 
 std::size_t PriorityQueue::size() const noexcept {
@@ -22,8 +25,8 @@ TreeNode* PriorityQueue::findMin() const noexcept {
     if (items_.empty())
         return nullptr;
 
-    // otherwise, return the minimum value (at the back).
-    return items_.back();
+    // otherwise, return the minimum value (at the root of the heap).
+    return items_.front();
 }
 
 TreeNode* PriorityQueue::extractMin() noexcept {
@@ -31,7 +34,9 @@ TreeNode* PriorityQueue::extractMin() noexcept {
     if (items_.empty())
         return nullptr;
 
-    // otherwise, extract the minimum value (at the back).
+    // otherwise, pop_heap swaps the minimum value to the back and re-heapifies the rest,
+    // so we can take it off the end.
+    std::pop_heap(items_.begin(), items_.end(), higherPriority);
     TreeNode* minNode = items_.back();
     items_.pop_back();
     return minNode;
@@ -39,28 +44,29 @@ TreeNode* PriorityQueue::extractMin() noexcept {
 
 void PriorityQueue::deleteMin() noexcept {
     // if the vector isn't empty, delete the minimum value.
-    if (!items_.empty())
+    if (!items_.empty()) {
+        std::pop_heap(items_.begin(), items_.end(), higherPriority);
         items_.pop_back();
+    }
 }
 
 void PriorityQueue::insert(TreeNode* node) {
-    // find the right place to insert...
-    auto iterator = items_.begin();
-    while (iterator != items_.end() && higherPriority(*iterator, node)) {
-        iterator += 1;
-    }
-
-    // then insert it!
-    items_.insert(iterator, node);
+    // put it at the end, then sift it up to where it belongs
+    items_.push_back(node);
+    std::push_heap(items_.begin(), items_.end(), higherPriority);
 }
 
 void PriorityQueue::print(std::ostream& os) const {
     // print size first
     os << "PriorityQueue (size=" << items_.size() << ")" << std::endl;
 
+    // the heap itself isn't in order, so print a sorted copy
+    std::vector<TreeNode*> sorted = items_;
+    std::sort(sorted.begin(), sorted.end(), higherPriority);
+
     // then, print the elements
-    for (int i = 0; i < items_.size(); ++i) {
-        const TreeNode* node = items_[i];
+    for (std::size_t i = 0; i < sorted.size(); ++i) {
+        const TreeNode* node = sorted[i];
         os << "  [" << i << "] ";
 
         if (node->isLeaf())
@@ -84,14 +90,7 @@ bool PriorityQueue::higherPriority(const TreeNode* a, const TreeNode* b) noexcep
         return a->word < b->word;
 }
 
-bool PriorityQueue::isSorted() const {
-    // loop over the whole vector and check for anything out of place
-    for (int i = 1; i < items_.size(); ++i) {
-        if (!higherPriority(items_[i - 1], items_[i]) && items_[i - 1] != items_[i]) {
-            if (higherPriority(items_[i], items_[i - 1]))
-                return false;
-        }
-    }
-
-    return true;
-}
\ No newline at end of file
+bool PriorityQueue::isHeap() const {
+    // check that no parent sorts before either of its children
+    return std::is_heap(items_.begin(), items_.end(), higherPriority);
+}
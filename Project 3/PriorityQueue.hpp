@@ -13,33 +13,38 @@
 class PriorityQueue {
 public:
     // Non‑owning: does NOT delete the TreeNode* it stores.
-    // The constructor takes an initial set of leaves and sorts them internally.
+    // The constructor takes an initial set of leaves and heapifies them internally (O(N)).
     explicit PriorityQueue(std::vector<TreeNode*> nodes);
     ~PriorityQueue() = default;
 
     [[nodiscard]] std::size_t size() const noexcept;
     [[nodiscard]] bool empty() const noexcept;
 
-    // Min accessors (MIN = items_.back() under our ordering)
+    // Min accessors (MIN = items_.front(), the root of the heap)
     [[nodiscard]] TreeNode* findMin() const noexcept;   // nullptr if empty
-    TreeNode* extractMin() noexcept;                    // remove+return min, or nullptr
-    void deleteMin() noexcept;                          // remove min if present
+    TreeNode* extractMin() noexcept;                    // remove+return min, or nullptr (O(log N))
+    void deleteMin() noexcept;                          // remove min if present (O(log N))
 
-    // Insert while maintaining the invariant (O(N) due to shifting)
+    // Insert while maintaining the invariant (O(log N), one sift up the heap)
     // Stores the pointer without taking ownership.
     void insert(TreeNode* node);
 
-    // Debug printing
+    // Debug printing (highest priority first, so the MIN is printed last)
     void print(std::ostream& os = std::cout) const;
 
+    // The queue's ordering: does 'a' come before 'b'? (freq desc, then key_word asc; the MIN comes last)
+    // Public so other code can reproduce the exact same tie-breaking.
+    static bool higherPriority(const TreeNode* a, const TreeNode* b) noexcept;
+
 private:
-    // Invariant: items_ is kept sorted by HigherPriority(a,b)
-    // i.e., (freq desc, key_word asc). Therefore the MIN is items_.back().
+    // Invariant: items_ is a binary heap under HigherPriority(a,b), i.e. (freq desc, key_word asc),
+    // arranged so the element that sorts LAST - the MIN - is at items_.front().
+    // No two queued nodes ever tie (distinct words), so nodes come out in exactly the order
+    // a fully sorted queue would give.
     // Ownership: items_ does NOT own the pointers.
     std::vector<TreeNode*> items_;
 
-    static bool higherPriority(const TreeNode* a, const TreeNode* b) noexcept; // a before b?
-    bool isSorted() const; // for assertions/tests only
+    bool isHeap() const; // for assertions/tests only
 };
 
 
@@ -0,0 +1,170 @@
+#include "Profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+    // how many profilers are running (allocations are only counted while there's at least one)
+    std::atomic<int> countingProfilers{0};
+    std::atomic<std::uint64_t> allocationCount{0};
+
+    void* allocate(const std::size_t size) {
+        if (countingProfilers.load(std::memory_order_relaxed) != 0)
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+        // malloc(0) may return nullptr, but new has to give back a unique pointer
+        if (void* p = std::malloc(size == 0 ? 1 : size))
+            return p;
+        throw std::bad_alloc();
+    }
+
+    // file names go into JSON strings
+    void putJsonString(std::ostream& os, const std::string_view text) {
+        os << '"';
+        for (const char c : text) {
+            if (c == '"' || c == '\\')
+                os << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20)
+                os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+                   << std::dec << std::setfill(' ');
+            else
+                os << c;
+        }
+        os << '"';
+    }
+}
+
+// Every plain new/delete in the program goes through these, so allocations can be counted.
+// (The array and nothrow forms call these by default.)
+void* operator new(const std::size_t size) { return allocate(size); }
+void* operator new[](const std::size_t size) { return allocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+
+Profiler::Profiler(const bool enabled) : enabled_(enabled) {
+    if (!enabled_)
+        return;
+
+    countingProfilers.fetch_add(1, std::memory_order_relaxed);
+    origin_ = now();
+}
+
+Profiler::~Profiler() {
+    if (enabled_)
+        countingProfilers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+void Profiler::stage(const std::string_view name) {
+    if (!enabled_)
+        return;
+
+    closeStage();
+    stages_.push_back(StageProfile{std::string(name)});
+    stageStart_ = now();
+    open_ = true;
+}
+
+void Profiler::finish() {
+    if (enabled_)
+        closeStage();
+}
+
+void Profiler::closeStage() {
+    if (!open_)
+        return;
+
+    const Snapshot end = now();
+    StageProfile& stage = stages_.back();
+    stage.startMs = stageStart_.wallMs - origin_.wallMs;
+    stage.wallMs = end.wallMs - stageStart_.wallMs;
+    stage.cpuMs = end.cpuMs - stageStart_.cpuMs;
+    stage.peakRssDeltaKb = end.peakRssKb - stageStart_.peakRssKb;
+    stage.allocations = end.allocations - stageStart_.allocations;
+    open_ = false;
+}
+
+
+Profiler::Snapshot Profiler::now() const {
+    Snapshot snapshot;
+    snapshot.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    snapshot.allocations = allocationCount.load(std::memory_order_relaxed);
+
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        // both are in 100 ns units
+        const auto ticks = [](const FILETIME& t) {
+            return static_cast<double>((static_cast<std::uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime);
+        };
+        snapshot.cpuMs = (ticks(kernel) + ticks(user)) / 1e4;
+    }
+
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof memory))
+        snapshot.peakRssKb = static_cast<std::int64_t>(memory.PeakWorkingSetSize / 1024);
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        snapshot.cpuMs = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 +
+                         static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+#ifdef __APPLE__
+        snapshot.peakRssKb = static_cast<std::int64_t>(usage.ru_maxrss / 1024); // bytes there, KB everywhere else
+#else
+        snapshot.peakRssKb = static_cast<std::int64_t>(usage.ru_maxrss);
+#endif
+    }
+#endif
+
+    return snapshot;
+}
+
+
+void Profiler::writeJsonLines(std::ostream& os, const std::string_view file) const {
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << std::fixed << std::setprecision(3);
+
+    for (const StageProfile& stage : stages_) {
+        os << "{\"file\":";
+        putJsonString(os, file);
+        os << ",\"stage\":";
+        putJsonString(os, stage.name);
+        os << ",\"wall_ms\":" << stage.wallMs << ",\"cpu_ms\":" << stage.cpuMs
+           << ",\"peak_rss_delta_kb\":" << stage.peakRssDeltaKb << ",\"allocations\":" << stage.allocations << "}\n";
+    }
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void Profiler::writeChromeTrace(std::ostream& os) const {
+    // complete ("X") events, timestamps and durations in microseconds
+    os << "{\"traceEvents\":[\n" << std::fixed << std::setprecision(3);
+    for (std::size_t i = 0; i < stages_.size(); ++i) {
+        const StageProfile& stage = stages_[i];
+        os << "{\"name\":";
+        putJsonString(os, stage.name);
+        os << ",\"cat\":\"stage\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << stage.startMs * 1e3
+           << ",\"dur\":" << stage.wallMs * 1e3 << ",\"args\":{\"cpu_ms\":" << stage.cpuMs
+           << ",\"peak_rss_delta_kb\":" << stage.peakRssDeltaKb << ",\"allocations\":" << stage.allocations << "}}"
+           << (i + 1 < stages_.size() ? ",\n" : "\n");
+    }
+    os << "]}\n" << std::defaultfloat;
+}
@@ -0,0 +1,68 @@
+#ifndef PROJECT_3_PROFILER_HPP
+#define PROJECT_3_PROFILER_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// What one stage of a run cost.
+struct StageProfile {
+    std::string name;
+    double startMs = 0.0;          // since the profiler was created
+    double wallMs = 0.0;
+    double cpuMs = 0.0;            // user + system, every thread of the process
+    std::int64_t peakRssDeltaKb = 0; // how much the process's peak resident set grew during the stage
+    std::uint64_t allocations = 0; // operator new calls, every thread of the process
+};
+
+// Times the stages of a run for --profile. main calls stage() at the top of every step (which closes the step before)
+// and finish() after the last one. A disabled profiler does nothing but return from each call, and the global
+// operator new it counts allocations through only checks a flag, so leaving the calls in costs nothing measurable.
+//
+// CPU time, peak RSS and allocations are process-wide, which is why main only allows --profile in a --batch run
+// that does one file at a time (--batch-threads=1).
+class Profiler {
+public:
+    explicit Profiler(bool enabled);
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    void stage(std::string_view name);
+    void finish();
+
+    [[nodiscard]] bool enabled() const noexcept { return enabled_; }
+    [[nodiscard]] const std::vector<StageProfile>& stages() const noexcept { return stages_; }
+
+    // One JSON object per stage and line, tagged with the input file:
+    //   {"file":"...","stage":"tokenize","wall_ms":1.234,"cpu_ms":1.2,"peak_rss_delta_kb":512,"allocations":42}
+    void writeJsonLines(std::ostream& os, std::string_view file) const;
+
+    // The stages as a Chrome trace-event file (open it in chrome://tracing or Perfetto).
+    void writeChromeTrace(std::ostream& os) const;
+
+private:
+    // process-wide counters at one moment
+    struct Snapshot {
+        double wallMs = 0.0;
+        double cpuMs = 0.0;
+        std::int64_t peakRssKb = 0;
+        std::uint64_t allocations = 0;
+    };
+
+    bool enabled_;
+    bool open_ = false;     // a stage is running
+    Snapshot origin_;       // when the profiler was created
+    Snapshot stageStart_;
+    std::vector<StageProfile> stages_;
+
+    [[nodiscard]] Snapshot now() const;
+    void closeStage();
+};
+
+
+#endif //PROJECT_3_PROFILER_HPP
@@ -0,0 +1,275 @@
+#include "ScanKernels.hpp"
+
+#include <bit>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+// the vector kernels need x86 intrinsics plus GCC/Clang's per-function target attributes,
+// so every other build only gets the scalar kernel
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define SCAN_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    // readWord's isalpha() in the default "C" locale, without the locale lookup
+    bool isLetter(const char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    ScanKernel bestKernel() noexcept {
+#ifdef SCAN_KERNELS_X86
+        static const ScanKernel best = __builtin_cpu_supports("avx2") ? ScanKernel::AVX2 : ScanKernel::SSE2;
+        return best;
+#else
+        return ScanKernel::Scalar;
+#endif
+    }
+
+
+    // ---------- scalar kernel ----------
+
+    void findWordsScalar(const char* first, const char* last, std::vector<std::string_view>& views) {
+        const char* p = first;
+
+        while (p != last) {
+            // skip over any leading non-letter characters
+            while (p != last && !isLetter(*p))
+                ++p;
+
+            // if we've reached the end of the range, there are no more words
+            if (p == last)
+                return;
+
+            // otherwise, we've hit a letter, so a word starts here
+            const char* start = p++;
+
+            // keep going over letters, and over apostrophes that have a letter right after them
+            while (p != last && (isLetter(*p) || (*p == '\'' && p + 1 != last && isLetter(p[1]))))
+                ++p;
+
+            views.emplace_back(start, static_cast<std::size_t>(p - start));
+        }
+    }
+
+    void lowercaseScalar(const char* src, const std::size_t length, char* dst) noexcept {
+        for (std::size_t i = 0; i < length; ++i)
+            dst[i] = static_cast<char>(tolower(static_cast<unsigned char>(src[i])));
+    }
+
+
+#ifdef SCAN_KERNELS_X86
+    // ---------- shared block logic for the vector kernels ----------
+    // The vector kernels classify 64 bytes at a time into two bitmasks (bit i = byte i):
+    // which bytes are letters and which are apostrophes. Everything below is plain integer math.
+
+    constexpr std::size_t kBlock = 64;
+
+    // what one block needs to know about the block before it
+    struct BlockCarry {
+        std::uint64_t prevLetter = 0;  // bit 0 set if the previous block ended in a letter
+        std::uint64_t prevInWord = 0;  // bit 0 set if the previous block ended inside a word
+        const char* wordStart = nullptr;
+    };
+
+    inline void emitBlockWords(const char* base, const std::uint64_t letters, const std::uint64_t apostrophes,
+                               const bool nextIsLetter, BlockCarry& carry, std::vector<std::string_view>& views) {
+        // an apostrophe is part of a word only with a letter on both sides
+        const std::uint64_t letterBefore = (letters << 1) | carry.prevLetter;
+        const std::uint64_t letterAfter = (letters >> 1) | (static_cast<std::uint64_t>(nextIsLetter) << 63);
+        const std::uint64_t inWord = letters | (apostrophes & letterBefore & letterAfter);
+
+        // every set bit here is a word starting (inWord = 1) or ending (inWord = 0) at that byte
+        std::uint64_t edges = inWord ^ ((inWord << 1) | carry.prevInWord);
+        while (edges != 0) {
+            const int i = std::countr_zero(edges);
+            if ((inWord >> i) & 1)
+                carry.wordStart = base + i;
+            else
+                views.emplace_back(carry.wordStart, static_cast<std::size_t>(base + i - carry.wordStart));
+            edges &= edges - 1;
+        }
+
+        carry.prevLetter = letters >> 63;
+        carry.prevInWord = inWord >> 63;
+    }
+
+    // Runs 'classify' over every full block, then over a zero-padded copy of the tail
+    // (zero bytes are separators, so padding can't create or extend a word).
+    template <typename Classify>
+    inline void findWordsBlocks(const char* first, const char* last, std::vector<std::string_view>& views,
+                                Classify classify) {
+        BlockCarry carry;
+        std::uint64_t letters = 0;
+        std::uint64_t apostrophes = 0;
+
+        const char* p = first;
+        for (; static_cast<std::size_t>(last - p) >= kBlock; p += kBlock) {
+            classify(p, letters, apostrophes);
+            const bool nextIsLetter = p + kBlock != last && isLetter(p[kBlock]);
+            emitBlockWords(p, letters, apostrophes, nextIsLetter, carry, views);
+        }
+
+        if (p != last) {
+            alignas(kBlock) char padded[kBlock] = {};
+            std::memcpy(padded, p, static_cast<std::size_t>(last - p));
+            classify(padded, letters, apostrophes);
+            emitBlockWords(p, letters, apostrophes, false, carry, views);
+        }
+
+        // a word that runs right up to the end of the range
+        if (carry.prevInWord)
+            views.emplace_back(carry.wordStart, static_cast<std::size_t>(last - carry.wordStart));
+    }
+
+
+    // ---------- SSE2 kernel ----------
+
+    // bit i of the result is set when byte i of 'p' is an ASCII letter / an apostrophe
+    inline void classify16(const char* p, std::uint32_t& letters, std::uint32_t& apostrophes) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // OR-ing in 0x20 folds 'A'-'Z' onto 'a'-'z'; shifting 'a' down to -128 turns the
+        // unsigned range check into one signed compare
+        const __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+        const __m128i shifted = _mm_add_epi8(folded, _mm_set1_epi8(static_cast<char>(0x80 - 'a')));
+        const __m128i isLetter = _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(-128 + 26)));
+        const __m128i isApostrophe = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\''));
+
+        letters = static_cast<std::uint32_t>(_mm_movemask_epi8(isLetter));
+        apostrophes = static_cast<std::uint32_t>(_mm_movemask_epi8(isApostrophe));
+    }
+
+    void findWordsSSE2(const char* first, const char* last, std::vector<std::string_view>& views) {
+        findWordsBlocks(first, last, views, [](const char* p, std::uint64_t& letters, std::uint64_t& apostrophes) {
+            letters = 0;
+            apostrophes = 0;
+            for (int i = 0; i < 4; ++i) {
+                std::uint32_t l, a;
+                classify16(p + 16 * i, l, a);
+                letters |= static_cast<std::uint64_t>(l) << (16 * i);
+                apostrophes |= static_cast<std::uint64_t>(a) << (16 * i);
+            }
+        });
+    }
+
+    void lowercaseSSE2(const char* src, std::size_t length, const char* limit, char* dst) noexcept {
+        // word bytes are letters or apostrophes, and OR-ing 0x20 lowercases the first and keeps the second
+        const __m128i caseBit = _mm_set1_epi8(0x20);
+        for (; length >= 16; src += 16, dst += 16, length -= 16)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                             _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), caseBit));
+
+        if (length == 0)
+            return;
+
+        // the rest of the word still fits in one block if the buffer extends far enough past it
+        if (limit - src >= 16) {
+            alignas(16) char block[16];
+            _mm_store_si128(reinterpret_cast<__m128i*>(block),
+                            _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), caseBit));
+            std::memcpy(dst, block, length);
+        }
+        else
+            lowercaseScalar(src, length, dst);
+    }
+
+
+    // ---------- AVX2 kernel ----------
+
+    __attribute__((target("avx2")))
+    inline std::uint32_t letterMask32(const __m256i bytes) {
+        const __m256i folded = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+        const __m256i shifted = _mm256_add_epi8(folded, _mm256_set1_epi8(static_cast<char>(0x80 - 'a')));
+        const __m256i isLetter = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + 26)), shifted);
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(isLetter));
+    }
+
+    __attribute__((target("avx2")))
+    inline std::uint32_t apostropheMask32(const __m256i bytes) {
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\''))));
+    }
+
+    __attribute__((target("avx2")))
+    void findWordsAVX2(const char* first, const char* last, std::vector<std::string_view>& views) {
+        findWordsBlocks(first, last, views, [](const char* p, std::uint64_t& letters, std::uint64_t& apostrophes)
+                __attribute__((target("avx2"))) {
+            const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+            letters = letterMask32(low) | (static_cast<std::uint64_t>(letterMask32(high)) << 32);
+            apostrophes = apostropheMask32(low) | (static_cast<std::uint64_t>(apostropheMask32(high)) << 32);
+        });
+    }
+
+    __attribute__((target("avx2")))
+    void lowercaseAVX2(const char* src, std::size_t length, const char* limit, char* dst) noexcept {
+        const __m256i caseBit = _mm256_set1_epi8(0x20);
+        for (; length >= 32; src += 32, dst += 32, length -= 32)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                                _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), caseBit));
+
+        if (length == 0)
+            return;
+
+        if (limit - src >= 32) {
+            alignas(32) char block[32];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(block),
+                               _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), caseBit));
+            std::memcpy(dst, block, length);
+        }
+        else
+            lowercaseSSE2(src, length, limit, dst);
+    }
+#endif
+}
+
+
+ScanKernel resolveScanKernel(const ScanKernel requested) noexcept {
+    // Auto means "the best one we have"; anything the CPU can't run gets the best one it can
+    const ScanKernel best = bestKernel();
+    if (requested == ScanKernel::Auto || static_cast<int>(requested) > static_cast<int>(best))
+        return best;
+
+    return requested;
+}
+
+const char* scanKernelName(const ScanKernel kernel) noexcept {
+    switch (kernel) {
+        case ScanKernel::Auto:   return "auto";
+        case ScanKernel::Scalar: return "scalar";
+        case ScanKernel::SSE2:   return "sse2";
+        case ScanKernel::AVX2:   return "avx2";
+    }
+    return "unknown";
+}
+
+void findWords(const ScanKernel kernel, const char* first, const char* last, std::vector<std::string_view>& views) {
+    switch (resolveScanKernel(kernel)) {
+#ifdef SCAN_KERNELS_X86
+        case ScanKernel::AVX2:
+            findWordsAVX2(first, last, views);
+            return;
+        case ScanKernel::SSE2:
+            findWordsSSE2(first, last, views);
+            return;
+#endif
+        default:
+            findWordsScalar(first, last, views);
+    }
+}
+
+void lowercaseWord(const ScanKernel kernel, const char* src, const std::size_t length, const char* limit,
+                   char* dst) noexcept {
+    switch (resolveScanKernel(kernel)) {
+#ifdef SCAN_KERNELS_X86
+        case ScanKernel::AVX2:
+            lowercaseAVX2(src, length, limit, dst);
+            return;
+        case ScanKernel::SSE2:
+            lowercaseSSE2(src, length, limit, dst);
+            return;
+#endif
+        default:
+            lowercaseScalar(src, length, dst);
+    }
+}
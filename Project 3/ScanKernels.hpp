@@ -0,0 +1,30 @@
+#ifndef PROJECT_3_SCANKERNELS_HPP
+#define PROJECT_3_SCANKERNELS_HPP
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Word-finding kernels for the memory-mapped Scanner path.
+// All of them follow the tokenization rules of Scanner::readWord: a word is a run of ASCII letters,
+// and an apostrophe belongs to the word only when it sits between two letters. Everything else separates.
+enum class ScanKernel {
+    Auto,   // best kernel this CPU supports
+    Scalar, // one byte at a time
+    SSE2,   // 16 bytes per compare
+    AVX2,   // 32 bytes per compare
+};
+
+// Auto becomes the best kernel this CPU supports; a kernel the CPU can't run falls back to the next best.
+[[nodiscard]] ScanKernel resolveScanKernel(ScanKernel requested) noexcept;
+[[nodiscard]] const char* scanKernelName(ScanKernel kernel) noexcept;
+
+// Append a view (original case) for every word in [first, last).
+void findWords(ScanKernel kernel, const char* first, const char* last, std::vector<std::string_view>& views);
+
+// Lowercase the 'length' word bytes at 'src' into 'dst'.
+// 'limit' is the end of the readable buffer around 'src', so the vector kernels can load whole blocks.
+void lowercaseWord(ScanKernel kernel, const char* src, std::size_t length, const char* limit, char* dst) noexcept;
+
+
+#endif //PROJECT_3_SCANKERNELS_HPP
@@ -4,11 +4,26 @@
 
 #include "Scanner.hpp"
 
+#include <algorithm>
 #include <utility>
 #include <iostream>
 #include <fstream>
 
 #include "utils.hpp"
+#include "Parallel.hpp"
+
+namespace {
+    // chunks smaller than this aren't worth a thread
+    constexpr std::size_t kMinChunkBytes = 1 << 16;
+
+    // how much of the file forEachToken holds in memory at once
+    constexpr std::size_t kStreamBufferBytes = 1 << 20;
+
+    // bytes that can be part of a word; a split point has to land on anything else
+    bool isWordByte(const char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '\'';
+    }
+}
 
 Scanner::Scanner(std::filesystem::path inputPath) {
     // You complete this...
@@ -94,4 +109,208 @@ error_type Scanner::tokenize(std::vector<std::string>& words, const std::filesys
 
     // otherwise, write words to our .tokens file!
     return writeVectorToFile(outputFile.string(), words);
-}
\ No newline at end of file
+}
+
+
+
+error_type Scanner::tokenizeViews(std::vector<std::string_view>& views) {
+    // map the whole input file; if that fails, throw an error
+    if (error_type status = mapped_.open(inputPath_); status != NO_ERROR)
+        return status;
+
+    const char* first = mapped_.data();
+    const char* last = first + mapped_.size();
+
+    // small files (or a single thread) get scanned directly
+    const std::size_t parts = std::min<std::size_t>(threads_, mapped_.size() / kMinChunkBytes);
+    if (parts <= 1) {
+        scanRange(first, last, views);
+        return NO_ERROR;
+    }
+
+    // otherwise, every thread scans its own slice into its own vector...
+    const std::vector<const char*> bounds = splitAtSeparators(first, last, parts);
+    std::vector<std::vector<std::string_view>> pieces(parts);
+
+    runOnThreads(parts, [&](const std::size_t i) {
+        scanRange(bounds[i], bounds[i + 1], pieces[i]);
+    });
+
+    // ...and the slices are glued back together in file order
+    std::size_t total = views.size();
+    for (const auto& piece : pieces)
+        total += piece.size();
+    views.reserve(total);
+
+    for (const auto& piece : pieces)
+        views.insert(views.end(), piece.begin(), piece.end());
+
+    return NO_ERROR;
+}
+
+
+
+std::string Scanner::materialize(const std::string_view view) const {
+    // copy the view, lowercasing as we go. the kernel may read past the end of the view
+    // (but never past the end of the mapping) so it can lowercase in whole blocks.
+    std::string word(view.size(), '\0');
+    const char* limit = view.data() + view.size();
+    if (view.data() >= mapped_.data() && limit <= mapped_.data() + mapped_.size())
+        limit = mapped_.data() + mapped_.size();
+
+    lowercaseWord(kernel_, view.data(), view.size(), limit, word.data());
+
+    return word;
+}
+
+
+
+void Scanner::materialize(const std::vector<std::string_view>& views, std::vector<std::string>& words) const {
+    // make room for every word, then let each thread fill in its own stretch of them
+    const std::size_t offset = words.size();
+    words.resize(offset + views.size());
+
+    const std::size_t parts = std::clamp<std::size_t>(threads_, 1, std::max<std::size_t>(views.size() / 4096, 1));
+    runOnThreads(parts, [&](const std::size_t part) {
+        const std::size_t begin = views.size() * part / parts;
+        const std::size_t end = views.size() * (part + 1) / parts;
+        for (std::size_t i = begin; i < end; ++i)
+            words[offset + i] = materialize(views[i]);
+    });
+}
+
+
+
+error_type Scanner::forEachToken(const std::function<void(std::string_view)>& visit) {
+    // open the file in binary; '\r' is a separator either way, so the tokens don't change
+    std::ifstream inputFile(inputPath_, std::ios::binary);
+
+    // if it didn't open correctly, throw an error
+    if (!inputFile.is_open())
+        return UNABLE_TO_OPEN_FILE;
+
+    std::vector<char> buffer(kStreamBufferBytes);
+    std::vector<std::string_view> views;
+    std::string word;
+    std::size_t carried = 0; // bytes at the front of the buffer left over from the previous block
+
+    while (true) {
+        // only happens if a single "word" is bigger than the whole buffer
+        if (carried == buffer.size())
+            buffer.resize(buffer.size() * 2);
+
+        // top the buffer up with the next block of the file
+        inputFile.read(buffer.data() + carried, static_cast<std::streamsize>(buffer.size() - carried));
+        if (inputFile.bad())
+            return UNABLE_TO_OPEN_FILE;
+
+        const bool atEnd = inputFile.eof();
+        const char* first = buffer.data();
+        const char* last = first + carried + static_cast<std::size_t>(inputFile.gcount());
+
+        // a word at the end of the block might keep going in the next one, so (unless this is the
+        // end of the file) only scan up to the last separator and keep the rest for next time
+        const char* cut = last;
+        if (!atEnd) {
+            while (cut != first && isWordByte(cut[-1]))
+                --cut;
+            if (cut != first)
+                --cut;
+        }
+
+        views.clear();
+        scanRange(first, cut, views);
+
+        for (const auto& view : views) {
+            word.resize(view.size());
+            lowercaseWord(kernel_, view.data(), view.size(), last, word.data());
+            visit(word);
+        }
+
+        if (atEnd)
+            return NO_ERROR;
+
+        // slide the unfinished tail to the front of the buffer
+        carried = static_cast<std::size_t>(last - cut);
+        std::copy(cut, last, buffer.data());
+    }
+}
+
+
+
+error_type Scanner::forEachTokenByLine(const std::function<void(std::string_view)>& visit,
+                                       const std::function<void()>& endOfLine) {
+    // "-" is stdin; anything else is opened like a file (a FIFO blocks here until its writer shows up)
+    std::ifstream inputFile;
+    std::istream* in = &std::cin;
+    if (inputPath_ != "-") {
+        inputFile.open(inputPath_, std::ios::binary);
+        if (!inputFile.is_open())
+            return UNABLE_TO_OPEN_FILE;
+        in = &inputFile;
+    }
+
+    // a line break is a separator, so no word is ever split between two lines
+    std::string line;
+    std::vector<std::string_view> views;
+    std::string word;
+    while (std::getline(*in, line)) {
+        views.clear();
+        scanRange(line.data(), line.data() + line.size(), views);
+
+        for (const auto& view : views) {
+            word.resize(view.size());
+            lowercaseWord(kernel_, view.data(), view.size(), line.data() + line.size(), word.data());
+            visit(word);
+        }
+        endOfLine();
+    }
+
+    return in->bad() ? UNABLE_TO_OPEN_FILE : NO_ERROR;
+}
+
+
+
+error_type Scanner::tokenizeIds(Vocabulary& vocab, std::vector<std::uint32_t>& ids) {
+    // stream the tokens straight into the vocabulary, keeping just the id of each one
+    return forEachToken([&](const std::string_view token) {
+        ids.push_back(vocab.intern(token));
+    });
+}
+
+
+
+void Scanner::setThreads(const unsigned threads) noexcept {
+    threads_ = resolveThreadCount(threads);
+}
+
+
+
+void Scanner::scanRange(const char* first, const char* last, std::vector<std::string_view>& views) const {
+    // the kernel does the actual work
+    findWords(kernel_, first, last, views);
+}
+
+
+
+std::vector<const char*> Scanner::splitAtSeparators(const char* first, const char* last, const std::size_t parts) {
+    std::vector<const char*> bounds;
+    bounds.reserve(parts + 1);
+    bounds.push_back(first);
+
+    const auto length = static_cast<std::size_t>(last - first);
+    for (std::size_t i = 1; i < parts; ++i) {
+        // start at an even share of the file (but never behind the previous split)...
+        const char* split = std::max(first + length * i / parts, bounds.back());
+
+        // ...then slide forward until we land on a separator. a separator is never part of a
+        // word and never decides whether its neighbours are, so both sides scan exactly as they would in one pass
+        while (split != last && isWordByte(*split))
+            ++split;
+
+        bounds.push_back(split);
+    }
+
+    bounds.push_back(last);
+    return bounds;
+}
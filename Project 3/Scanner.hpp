@@ -5,10 +5,15 @@
 #ifndef IMPLEMENTATION_FILETOWORDS_HPP
 #define IMPLEMENTATION_FILETOWORDS_HPP
 #include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
+#include <functional>
 
 #include "utils.hpp"
+#include "MappedFile.hpp"
+#include "ScanKernels.hpp"
+#include "Vocabulary.hpp"
 
 class Scanner {
 public:
@@ -22,6 +27,39 @@ public:
     error_type tokenize(std::vector<std::string>& words,
                         const std::filesystem::path& outputFile);
 
+    // Zero-copy tokenize: map the input file and collect every token as a view into the mapping.
+    // The views keep the input's original case; materialize() turns one into the lowercase token
+    // tokenize() would have produced. They stay valid until this Scanner is destroyed or maps again.
+    error_type tokenizeViews(std::vector<std::string_view>& views);
+
+    // Lowercase copy of a token view returned by tokenizeViews().
+    [[nodiscard]] std::string materialize(std::string_view view) const;
+
+    // Lowercase copies of all of 'views', in order (split across the worker threads).
+    void materialize(const std::vector<std::string_view>& views, std::vector<std::string>& words) const;
+
+    // Streaming tokenize: read the file through one fixed-size buffer and call visit(token) for every
+    // token in order, already lowercased. The view passed to 'visit' is only valid during that call.
+    // Memory use doesn't grow with the file, so this works on inputs bigger than RAM.
+    error_type forEachToken(const std::function<void(std::string_view)>& visit);
+
+    // Live tokenize, for a pipe or FIFO that is still being written to ("-" reads stdin): take one line at a time,
+    // as soon as its newline arrives, instead of waiting for a full block. Calls visit(token) for each of the line's
+    // tokens (same rules and lowercasing as forEachToken), then endOfLine().
+    error_type forEachTokenByLine(const std::function<void(std::string_view)>& visit,
+                                  const std::function<void()>& endOfLine);
+
+    // Interning tokenize: add every token to 'vocab' and append its id to 'ids'. The string form of
+    // each token lives only in 'vocab', once per distinct word.
+    error_type tokenizeIds(Vocabulary& vocab, std::vector<std::uint32_t>& ids);
+
+    // Pick the word-finding kernel tokenizeViews() uses (Auto by default). Every kernel yields the same tokens.
+    void setKernel(ScanKernel kernel) noexcept { kernel_ = kernel; }
+
+    // Number of threads tokenizeViews() splits the mapped file across (1 by default, 0 = one per core).
+    // The token order is the same as the serial scan.
+    void setThreads(unsigned threads) noexcept;
+
     ~Scanner() = default;
 
 private:
@@ -30,7 +68,17 @@ private:
     // digits, punctuation, hyphens/dashes, whitespace, and non‑ASCII are separators.
     static std::string readWord(std::ifstream &in);
 
+    // Same rules as readWord, applied to the bytes in [first, last); appends a view per token.
+    void scanRange(const char* first, const char* last, std::vector<std::string_view>& views) const;
+
+    // Split [first, last) into up to 'parts' ranges that all begin on a separator, so no word
+    // (or contraction) straddles two ranges. Returns the parts + 1 boundaries.
+    static std::vector<const char*> splitAtSeparators(const char* first, const char* last, std::size_t parts);
+
     std::filesystem::path inputPath_;
+    MappedFile mapped_; // backs the views handed out by tokenizeViews
+    ScanKernel kernel_ = ScanKernel::Auto;
+    unsigned threads_ = 1;
 };
 
 #endif //IMPLEMENTATION_FILETOWORDS_HPP
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "SyncIndex.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+namespace {
+    void putU64(std::ostream& os, const std::uint64_t value) {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i)
+            bytes[i] = static_cast<char>(value >> (8 * i));
+        os.write(bytes, 8);
+    }
+
+    bool getU64(std::istream& is, std::uint64_t& value) {
+        unsigned char bytes[8];
+        if (!is.read(reinterpret_cast<char*>(bytes), 8))
+            return false;
+
+        value = 0;
+        for (int i = 0; i < 8; ++i)
+            value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+        return true;
+    }
+}
+
+SyncPoint SyncIndex::pointBefore(const std::uint64_t token) const {
+    // points are evenly spaced, so there's nothing to search for
+    if (bits_.empty())
+        return {};
+
+    const std::uint64_t k = std::min<std::uint64_t>(token / interval_, bits_.size() - 1);
+    return point(static_cast<std::size_t>(k));
+}
+
+error_type SyncIndex::write(std::ostream& os) const {
+    os.write(kMagic, 4);
+    os.put(static_cast<char>(kVersion));
+    putU64(os, interval_);
+    putU64(os, totalTokens_);
+    putU64(os, totalBits_);
+    putU64(os, bits_.size());
+    for (const std::uint64_t bit : bits_)
+        putU64(os, bit);
+
+    return os.fail() ? FAILED_TO_WRITE_FILE : NO_ERROR;
+}
+
+error_type SyncIndex::read(std::istream& is) {
+    char magic[4];
+    if (!is.read(magic, 4) || std::memcmp(magic, kMagic, 4) != 0 || is.get() != kVersion)
+        return INVALID_FILE_FORMAT;
+
+    std::uint64_t points = 0;
+    if (!getU64(is, interval_) || !getU64(is, totalTokens_) || !getU64(is, totalBits_) || !getU64(is, points) ||
+        interval_ == 0)
+        return INVALID_FILE_FORMAT;
+
+    // make sure the point count agrees with the totals before trusting it with an allocation
+    if (points != (totalTokens_ + interval_ - 1) / interval_)
+        return INVALID_FILE_FORMAT;
+
+    bits_.resize(points);
+    for (std::uint64_t& bit : bits_) {
+        if (!getU64(is, bit) || bit > totalBits_)
+            return INVALID_FILE_FORMAT;
+    }
+
+    return NO_ERROR;
+}
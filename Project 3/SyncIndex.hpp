@@ -0,0 +1,72 @@
+#ifndef PROJECT_3_SYNCINDEX_HPP
+#define PROJECT_3_SYNCINDEX_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include "utils.hpp"
+
+
+// One place a decoder can start from: token number 'token' begins at bit 'bit' of the code stream.
+struct SyncPoint {
+    std::uint64_t token = 0;
+    std::uint64_t bit = 0;
+};
+
+// Sidecar index of a .code file: where every interval-th token starts (tokens 0, N, 2N, ...).
+// Decoding can begin at any of those points, so a slice of the file can be decoded without the bits before it,
+// and disjoint slices can be decoded on different threads. Bit offsets count code bits only
+// (not the binary header or the ASCII line breaks).
+//
+// File format (.idx, integers little-endian):
+//   "HUFI", u8 version (1), u64 interval, u64 total tokens, u64 total bits, u64 points, then u64 bit offset per point
+// A point's token number is implied by its position (point k is token k * interval), so each one costs 8 bytes.
+class SyncIndex {
+public:
+    SyncIndex() = default;
+    explicit SyncIndex(std::uint64_t interval) : interval_(interval == 0 ? 1 : interval) {}
+
+    // Called by the encoder for every token, before its code: records a point when the token is due for one.
+    void beforeToken(const std::uint64_t token, const std::uint64_t bit) {
+        if (token % interval_ == 0)
+            bits_.push_back(bit);
+    }
+
+    // Called once the whole stream is written.
+    void finish(std::uint64_t totalTokens, std::uint64_t totalBits) noexcept {
+        totalTokens_ = totalTokens;
+        totalBits_ = totalBits;
+    }
+
+    // Appends the points another encoder (of a later stretch of the same stream) recorded.
+    void append(const SyncIndex& later) { bits_.insert(bits_.end(), later.bits_.begin(), later.bits_.end()); }
+
+    [[nodiscard]] std::uint64_t interval() const noexcept { return interval_; }
+    [[nodiscard]] std::size_t size() const noexcept { return bits_.size(); }
+    [[nodiscard]] SyncPoint point(std::size_t k) const { return {k * interval_, bits_[k]}; }
+    [[nodiscard]] std::uint64_t totalTokens() const noexcept { return totalTokens_; }
+    [[nodiscard]] std::uint64_t totalBits() const noexcept { return totalBits_; }
+
+    // The last point at or before 'token'.
+    [[nodiscard]] SyncPoint pointBefore(std::uint64_t token) const;
+
+    // Size of the .idx file write() produces.
+    [[nodiscard]] std::uint64_t fileBytes() const noexcept { return kHeaderBytes + 8 * bits_.size(); }
+
+    error_type write(std::ostream& os) const;
+    error_type read(std::istream& is);
+
+private:
+    static constexpr char kMagic[4] = {'H', 'U', 'F', 'I'};
+    static constexpr std::uint8_t kVersion = 1;
+    static constexpr std::uint64_t kHeaderBytes = 4 + 1 + 4 * 8;
+
+    std::uint64_t interval_ = 1;
+    std::uint64_t totalTokens_ = 0;
+    std::uint64_t totalBits_ = 0;
+    std::vector<std::uint64_t> bits_; // bits_[k] = where token k * interval_ starts
+};
+
+
+#endif //PROJECT_3_SYNCINDEX_HPP
@@ -6,6 +6,7 @@
 #define PROJECT_3_TREENODE_HPP
 
 #include <string>
+#include <string_view>
 
 class TreeNode {
 public:
@@ -13,15 +14,17 @@ public:
     std::size_t count;
     TreeNode* left;
     TreeNode* right;
+    unsigned height; // height of the subtree rooted here (a leaf is 1) - kept balanced by BinSearchTree
 
     // constructor that takes 1 parameter - the word - only used by BinSearchTree
-    TreeNode(const std::string_view newWord) : word(newWord), count(1), left(nullptr), right(nullptr) {}
+    TreeNode(const std::string_view newWord) : word(newWord), count(1), left(nullptr), right(nullptr), height(1) {}
 
     // constructor that takes 2 parameters - the word and the frequency - only used by PriorityQueue
-    TreeNode(const std::string& newWord, size_t newCount) : word(newWord), count(newCount), left(nullptr), right(nullptr) {}
+    TreeNode(const std::string& newWord, size_t newCount) : word(newWord), count(newCount), left(nullptr), right(nullptr), height(1) {}
 
-    // constructor that takes 2 parameters - a left and right node - for merging two nodes to make a parent, not used yet
-    TreeNode(TreeNode* newLeft, TreeNode* newRight) : word(""), count(newLeft->count + newRight->count), left(newLeft), right(newRight) {
+    // constructor that takes 2 parameters - a left and right node - for merging two nodes to make a parent
+    TreeNode(TreeNode* newLeft, TreeNode* newRight) : word(""), count(newLeft->count + newRight->count), left(newLeft), right(newRight),
+                                                      height(1 + (newLeft->height > newRight->height ? newLeft->height : newRight->height)) {
         word = (newLeft->word < newRight->word) ? newLeft->word : newRight->word;
     }
 
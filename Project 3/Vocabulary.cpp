@@ -0,0 +1,104 @@
+#include "Vocabulary.hpp"
+
+#include <cstring>
+
+namespace {
+    constexpr std::size_t kFirstTableSize = 1024;
+
+    std::uint64_t mix(std::uint64_t h) noexcept {
+        // the splitmix64 finalizer: every input bit affects every output bit
+        h ^= h >> 30;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return h;
+    }
+}
+
+std::uint64_t Vocabulary::hash(const std::string_view word) noexcept {
+    // fold the word in 8 bytes at a time (most words fit in one or two loads)
+    std::uint64_t h = 0x9E3779B97F4A7C15ULL ^ word.size();
+    const char* p = word.data();
+    std::size_t left = word.size();
+
+    for (; left >= 8; p += 8, left -= 8) {
+        std::uint64_t chunk;
+        std::memcpy(&chunk, p, 8);
+        h = mix(h ^ chunk);
+    }
+
+    if (left > 0) {
+        std::uint64_t chunk = 0;
+        std::memcpy(&chunk, p, left);
+        h = mix(h ^ chunk);
+    }
+
+    return h;
+}
+
+std::uint32_t Vocabulary::intern(const std::string_view word) {
+    // keep the table at most half full so probe sequences stay short
+    if ((words_.size() + 1) * 2 > slots_.size())
+        grow();
+
+    const std::uint64_t wordHash = hash(word);
+    Slot& slot = slots_[probe(word, wordHash)];
+
+    // if we've seen it before, hand back the id it already has
+    if (slot.idPlusOne != 0)
+        return slot.idPlusOne - 1;
+
+    // otherwise, it gets the next id
+    const auto id = static_cast<std::uint32_t>(words_.size());
+    words_.emplace_back(word);
+    slot.idPlusOne = id + 1;
+    slot.hashTag = static_cast<std::uint32_t>(wordHash >> 32);
+
+    return id;
+}
+
+std::optional<std::uint32_t> Vocabulary::find(const std::string_view word) const {
+    // an empty table has nothing in it
+    if (slots_.empty())
+        return std::nullopt;
+
+    // look the word up; if it isn't there, say so
+    const Slot& slot = slots_[probe(word, hash(word))];
+    if (slot.idPlusOne == 0)
+        return std::nullopt;
+
+    return slot.idPlusOne - 1;
+}
+
+std::size_t Vocabulary::probe(const std::string_view word, const std::uint64_t wordHash) const noexcept {
+    // linear probing from the hash's home slot until we find the word or an empty slot
+    const std::size_t mask = slots_.size() - 1;
+    const auto tag = static_cast<std::uint32_t>(wordHash >> 32);
+
+    for (std::size_t i = wordHash & mask; ; i = (i + 1) & mask) {
+        const Slot& slot = slots_[i];
+        if (slot.idPlusOne == 0)
+            return i;
+        if (slot.hashTag == tag && words_[slot.idPlusOne - 1] == word)
+            return i;
+    }
+}
+
+void Vocabulary::grow() {
+    // double the table and put every word back in its new home slot
+    std::vector<Slot> old = std::move(slots_);
+    slots_.assign(old.empty() ? kFirstTableSize : old.size() * 2, Slot{});
+
+    const std::size_t mask = slots_.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.idPlusOne == 0)
+            continue;
+
+        const std::uint64_t wordHash = hash(words_[slot.idPlusOne - 1]);
+        std::size_t i = wordHash & mask;
+        while (slots_[i].idPlusOne != 0)
+            i = (i + 1) & mask;
+        slots_[i] = slot;
+    }
+}
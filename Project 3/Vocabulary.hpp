@@ -0,0 +1,47 @@
+#ifndef PROJECT_3_VOCABULARY_HPP
+#define PROJECT_3_VOCABULARY_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// Interning table: every distinct word gets a dense id (0, 1, 2, ... in first-seen order),
+// so later stages can count and encode with array indexing instead of string compares.
+// Lookups go through a flat open-addressing hash table (no per-entry allocation, linear probing).
+class Vocabulary {
+public:
+    Vocabulary() = default;
+
+    // Id of 'word', adding it if it's new.
+    std::uint32_t intern(std::string_view word);
+
+    // Id of 'word', or nullopt if it was never interned.
+    [[nodiscard]] std::optional<std::uint32_t> find(std::string_view word) const;
+
+    [[nodiscard]] const std::string& word(std::uint32_t id) const { return words_[id]; }
+    [[nodiscard]] std::size_t size() const noexcept { return words_.size(); }
+
+    // Hash used for the table (exposed so other word tables can share it).
+    [[nodiscard]] static std::uint64_t hash(std::string_view word) noexcept;
+
+private:
+    // one table slot: the word's id + 1 (0 = empty) and the top half of its hash,
+    // so most mismatches are caught without touching the string
+    struct Slot {
+        std::uint32_t idPlusOne = 0;
+        std::uint32_t hashTag = 0;
+    };
+
+    std::vector<std::string> words_; // id -> word
+    std::vector<Slot> slots_;        // size is a power of two, kept at most half full
+
+    // the slot 'word' lives in, or the empty slot where it would go
+    [[nodiscard]] std::size_t probe(std::string_view word, std::uint64_t wordHash) const noexcept;
+    void grow();
+};
+
+
+#endif //PROJECT_3_VOCABULARY_HPP
@@ -0,0 +1,38 @@
+#ifndef PROJECT_3_WORDCOUNTER_HPP
+#define PROJECT_3_WORDCOUNTER_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+// Which WordCounter main counts with (--counter=<bst|hash>).
+enum class CounterBackend {
+    Bst,  // BinSearchTree: word-ordered as it goes, and it has a height to report
+    Hash, // HashCounter: a flat hash table, one probe per token; sorted once at the end
+};
+
+// Counts how often every word turns up. Everything after counting only needs the sorted (word, count) list,
+// so how the counting is done is up to the implementation.
+class WordCounter {
+public:
+    virtual ~WordCounter() = default;
+
+    // Count one more 'word'.
+    virtual void insert(std::string_view word) = 0;
+
+    // Count every token in 'words'.
+    virtual void bulkInsert(const std::vector<std::string>& words) = 0;
+
+    // Every distinct word with its count, sorted by word (replaces whatever 'out' held).
+    virtual void sortedCounts(std::vector<std::pair<std::string, int>>& out) const = 0;
+
+    [[nodiscard]] virtual std::size_t size() const noexcept = 0; // distinct words
+    [[nodiscard]] virtual std::size_t minFrequency() const noexcept = 0;
+    [[nodiscard]] virtual std::size_t maxFrequency() const noexcept = 0;
+};
+
+
+#endif //PROJECT_3_WORDCOUNTER_HPP
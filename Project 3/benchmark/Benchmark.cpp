@@ -0,0 +1,310 @@
+// Project_3_bench: times each stage of the pipeline on synthetic Zipfian corpora of growing size and prints one CSV
+// row per (corpus, stage), so scaling curves can be plotted straight from the output.
+//
+//   Project_3_bench [--sizes=1K,64K,1M,16M] [--vocab=N] [--zipf=S] [--min-length=A] [--max-length=B]
+//                   [--short-words-first] [--seed=N] [--repeats=R] [--dir=DIR] [--csv=FILE] [--stream-above=SIZE]
+//
+// Corpora are written to DIR (default bench_corpora) and reused when a file for the same spec is already there.
+// Every stage runs R times (default 3) on the same input and the fastest run is reported.
+//
+// Up to --stream-above (default 256M) the token list is built once and every stage runs on it in memory.
+// Bigger corpora are never held in memory: each stage reads the file again through Scanner::forEachToken
+// (so counting and encoding include tokenizing) and only the vocabulary is kept, which is what lets the
+// sizes run up to whatever fits on disk.
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "BinSearchTree.hpp"
+#include "CorpusGenerator.hpp"
+#include "HashCounter.hpp"
+#include "HuffmanTree.hpp"
+#include "NodeArena.hpp"
+#include "PriorityQueue.hpp"
+#include "Scanner.hpp"
+#include "TreeNode.hpp"
+#include "utils.hpp"
+
+namespace {
+    struct BenchOptions {
+        std::vector<std::uint64_t> sizes = {1 << 10, 64 << 10, 1 << 20, 16 << 20};
+        CorpusSpec spec;
+        unsigned repeats = 3;
+        std::string dir = "bench_corpora";
+        std::string csvFileName; // empty = stdout
+        std::uint64_t streamAbove = 256 << 20; // corpora bigger than this are streamed instead of held in memory
+    };
+
+    // "64K", "16M", "10G" (powers of 1024) or plain bytes
+    bool parseSize(const std::string& text, std::uint64_t& bytes) {
+        try {
+            std::size_t used = 0;
+            bytes = std::stoull(text, &used);
+            const std::string suffix = text.substr(used);
+            if (suffix == "K" || suffix == "k")
+                bytes <<= 10;
+            else if (suffix == "M" || suffix == "m")
+                bytes <<= 20;
+            else if (suffix == "G" || suffix == "g")
+                bytes <<= 30;
+            else if (!suffix.empty())
+                return false;
+        } catch (const std::exception&) {
+            return false;
+        }
+        return bytes > 0;
+    }
+
+    bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+        try {
+            for (int i = 1; i < argc; ++i) {
+                const std::string arg = argv[i];
+                const std::string value = arg.substr(arg.find('=') + 1);
+
+                if (arg.rfind("--sizes=", 0) == 0) {
+                    options.sizes.clear();
+                    for (std::size_t start = 0; start <= value.size(); ) {
+                        const std::size_t comma = std::min(value.find(',', start), value.size());
+                        std::uint64_t bytes = 0;
+                        if (!parseSize(value.substr(start, comma - start), bytes))
+                            return false;
+                        options.sizes.push_back(bytes);
+                        start = comma + 1;
+                    }
+                }
+                else if (arg.rfind("--vocab=", 0) == 0)
+                    options.spec.vocabulary = std::stoull(value);
+                else if (arg.rfind("--zipf=", 0) == 0)
+                    options.spec.zipfExponent = std::stod(value);
+                else if (arg.rfind("--min-length=", 0) == 0)
+                    options.spec.minWordLength = static_cast<unsigned>(std::stoul(value));
+                else if (arg.rfind("--max-length=", 0) == 0)
+                    options.spec.maxWordLength = static_cast<unsigned>(std::stoul(value));
+                else if (arg == "--short-words-first")
+                    options.spec.shortWordsFirst = true;
+                else if (arg.rfind("--seed=", 0) == 0)
+                    options.spec.seed = std::stoull(value);
+                else if (arg.rfind("--repeats=", 0) == 0)
+                    options.repeats = std::max(1u, static_cast<unsigned>(std::stoul(value)));
+                else if (arg.rfind("--dir=", 0) == 0)
+                    options.dir = value;
+                else if (arg.rfind("--csv=", 0) == 0)
+                    options.csvFileName = value;
+                else if (arg.rfind("--stream-above=", 0) == 0) {
+                    if (!parseSize(value, options.streamAbove))
+                        return false;
+                }
+                else
+                    return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        return !options.sizes.empty();
+    }
+
+    // Swallows whatever encode() writes, but keeps track of the position so the binary format can seek back
+    // to its header. Keeps the disk out of the encode timings.
+    class DiscardBuffer : public std::streambuf {
+    protected:
+        int_type overflow(const int_type c) override {
+            position_++;
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char*, const std::streamsize count) override {
+            position_ += count;
+            return count;
+        }
+
+        pos_type seekoff(const off_type offset, const std::ios_base::seekdir dir, std::ios_base::openmode) override {
+            if (dir == std::ios_base::beg)
+                position_ = offset;
+            else if (dir == std::ios_base::cur)
+                position_ += offset;
+            else
+                return pos_type(off_type(-1));
+            return pos_type(position_);
+        }
+
+        pos_type seekpos(const pos_type position, const std::ios_base::openmode mode) override {
+            return seekoff(off_type(position), std::ios_base::beg, mode);
+        }
+
+    private:
+        off_type position_ = 0;
+    };
+
+    // fastest of 'repeats' runs of 'run', in seconds
+    template <typename Run>
+    double bestOf(const unsigned repeats, Run run) {
+        double best = 0.0;
+        for (unsigned i = 0; i < repeats; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+            if (i == 0 || seconds.count() < best)
+                best = seconds.count();
+        }
+        return best;
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--sizes=1K,64K,1M,16M] [--vocab=N] [--zipf=S] [--min-length=A] [--max-length=B]"
+                     " [--short-words-first] [--seed=N] [--repeats=R] [--dir=DIR] [--csv=FILE] [--stream-above=SIZE]\n";
+        return 1;
+    }
+
+    std::error_code dirError;
+    std::filesystem::create_directories(options.dir, dirError);
+    if (error_type status; (status = directoryExists(options.dir)) != NO_ERROR)
+        exitOnError(status, options.dir);
+
+    std::ofstream csvFile;
+    if (!options.csvFileName.empty()) {
+        csvFile.open(options.csvFileName, std::ios::out | std::ios::trunc);
+        if (!csvFile.is_open())
+            exitOnError(UNABLE_TO_OPEN_FILE_FOR_WRITING, options.csvFileName);
+    }
+    std::ostream& csv = options.csvFileName.empty() ? std::cout : csvFile;
+
+    csv << "corpus_bytes,vocabulary,zipf_exponent,tokens,distinct_words,mode,stage,items,best_seconds,items_per_second,corpus_mb_per_second\n";
+
+    for (const std::uint64_t size : options.sizes) {
+        CorpusSpec spec = options.spec;
+        spec.bytes = size;
+        const CorpusGenerator generator(spec);
+        const std::filesystem::path corpus = std::filesystem::path(options.dir) / generator.fileName();
+
+        // the corpus is deterministic, so one written earlier is as good as a new one
+        double generateSeconds = 0.0;
+        if (!std::filesystem::exists(corpus)) {
+            generateSeconds = bestOf(1, [&] {
+                if (error_type status = generator.write(corpus); status != NO_ERROR)
+                    exitOnError(status, corpus.string());
+            });
+        }
+        const auto corpusBytes = static_cast<double>(std::filesystem::file_size(corpus));
+
+        const bool streamed = corpusBytes > static_cast<double>(options.streamAbove);
+
+        // one pass over the corpus from disk, for the streamed stages
+        const auto eachToken = [&](const std::function<void(std::string_view)>& visit) {
+            Scanner scanner(corpus);
+            if (error_type status = scanner.forEachToken(visit); status != NO_ERROR)
+                exitOnError(status, corpus.string());
+        };
+
+        // every stage gets the previous stage's output, built once outside the timed runs
+        // (streamed, only the token count and the counts themselves are kept)
+        std::vector<std::string> tokens;
+        std::uint64_t tokenCount = 0;
+        const double tokenizeSeconds = bestOf(options.repeats, [&] {
+            tokens.clear();
+            tokenCount = 0;
+            if (streamed) {
+                eachToken([&](std::string_view) { tokenCount++; });
+                return;
+            }
+            Scanner scanner(corpus);
+            if (error_type status = scanner.tokenize(tokens); status != NO_ERROR)
+                exitOnError(status, corpus.string());
+            tokenCount = tokens.size();
+        });
+
+        // both counting backends, up to the same sorted list
+        const auto countWith = [&](WordCounter& counter) {
+            if (streamed)
+                eachToken([&](const std::string_view token) { counter.insert(token); });
+            else
+                counter.bulkInsert(tokens);
+        };
+
+        const double bstSeconds = bestOf(options.repeats, [&] {
+            BinSearchTree bst;
+            countWith(bst);
+        });
+
+        std::vector<std::pair<std::string, int>> frequencies;
+        const double hashSeconds = bestOf(options.repeats, [&] {
+            HashCounter counter;
+            countWith(counter);
+            counter.sortedCounts(frequencies);
+        });
+
+        // build the queue from the leaves and drain it, as STEP 5 of main does for .freq
+        const double pqSeconds = bestOf(options.repeats, [&] {
+            NodeArena arena;
+            std::vector<TreeNode*> leaves;
+            leaves.reserve(frequencies.size());
+            for (const auto& [word, count] : frequencies)
+                leaves.push_back(arena.make(word, static_cast<std::size_t>(count)));
+
+            PriorityQueue pq(leaves);
+            while (!pq.empty())
+                pq.extractMin();
+        });
+
+        const double huffmanSeconds = bestOf(options.repeats, [&] {
+            [[maybe_unused]] const HuffmanTree built = HuffmanTree::buildFromCounts(frequencies);
+        });
+
+        const HuffmanTree tree = HuffmanTree::buildFromCounts(frequencies);
+        const auto encodeWith = [&](const CodeFormat format) {
+            return bestOf(options.repeats, [&] {
+                DiscardBuffer discard;
+                std::ostream sink(&discard);
+                error_type status = NO_ERROR;
+                if (streamed) {
+                    HuffmanTree::Encoder encoder(tree, sink, 80, format);
+                    eachToken([&](const std::string_view token) {
+                        if (status == NO_ERROR)
+                            status = encoder.put(token);
+                    });
+                    if (status == NO_ERROR)
+                        status = encoder.finish();
+                }
+                else
+                    status = tree.encode(tokens, sink, 80, format);
+                if (status != NO_ERROR)
+                    exitOnError(status, "encode");
+            });
+        };
+        const double encodeSeconds = encodeWith(CodeFormat::Ascii);
+        const double encodeBinarySeconds = encodeWith(CodeFormat::Binary);
+
+        const auto row = [&](const char* stage, const std::size_t items, const double seconds) {
+            csv << static_cast<std::uint64_t>(corpusBytes) << ',' << spec.vocabulary << ',' << spec.zipfExponent << ','
+                << tokenCount << ',' << frequencies.size() << ',' << (streamed ? "streamed" : "in_memory") << ','
+                << stage << ',' << items << ','
+                << std::setprecision(9) << seconds << ',' << std::setprecision(6)
+                << (seconds > 0 ? static_cast<double>(items) / seconds : 0.0) << ','
+                << (seconds > 0 ? corpusBytes / 1e6 / seconds : 0.0) << '\n';
+        };
+
+        if (generateSeconds > 0)
+            row("generate", tokenCount, generateSeconds);
+        row("tokenize", tokenCount, tokenizeSeconds);
+        row("bst_bulk_insert", tokenCount, bstSeconds);
+        row("hash_count", tokenCount, hashSeconds);
+        row("priority_queue", frequencies.size(), pqSeconds);
+        row("huffman_build", frequencies.size(), huffmanSeconds);
+        row("encode_ascii", tokenCount, encodeSeconds);
+        row("encode_binary", tokenCount, encodeBinarySeconds);
+        csv.flush();
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "CorpusGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <unordered_set>
+
+namespace {
+    // splitmix64: tiny, fast, and the same sequence everywhere
+    class Random {
+    public:
+        explicit Random(const std::uint64_t seed) : state_(seed) {}
+
+        std::uint64_t next() noexcept {
+            std::uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        // uniform in [0, 1)
+        double unit() noexcept { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+        // uniform in [low, high]
+        unsigned between(const unsigned low, const unsigned high) noexcept {
+            return low + static_cast<unsigned>(next() % (static_cast<std::uint64_t>(high - low) + 1));
+        }
+
+    private:
+        std::uint64_t state_;
+    };
+
+    constexpr unsigned kWordsPerLine = 16;
+}
+
+
+CorpusGenerator::CorpusGenerator(const CorpusSpec& spec) : spec_(spec) {
+    spec_.vocabulary = std::max<std::size_t>(spec_.vocabulary, 1);
+    spec_.minWordLength = std::max(spec_.minWordLength, 1u);
+    spec_.maxWordLength = std::max(spec_.maxWordLength, spec_.minWordLength);
+
+    // the vocabulary: random distinct lowercase words
+    Random random(spec_.seed);
+    std::unordered_set<std::string> seen;
+    words_.reserve(spec_.vocabulary);
+    while (words_.size() < spec_.vocabulary) {
+        unsigned length = random.between(spec_.minWordLength, spec_.maxWordLength);
+
+        // if the lengths allowed are running out of unused words, go longer rather than loop forever
+        for (unsigned attempt = 0; ; ++attempt) {
+            if (attempt > 0 && attempt % 64 == 0)
+                length++;
+
+            std::string word(length, 'a');
+            for (char& c : word)
+                c = static_cast<char>('a' + random.next() % 26);
+            if (seen.insert(word).second) {
+                words_.push_back(std::move(word));
+                break;
+            }
+        }
+    }
+
+    if (spec_.shortWordsFirst) {
+        std::stable_sort(words_.begin(), words_.end(),
+                         [](const std::string& a, const std::string& b) { return a.size() < b.size(); });
+    }
+
+    // Zipf: weight 1 / r^s for rank r = 1..V
+    cumulative_.resize(words_.size());
+    double total = 0.0;
+    for (std::size_t r = 0; r < words_.size(); ++r) {
+        total += 1.0 / std::pow(static_cast<double>(r + 1), spec_.zipfExponent);
+        cumulative_[r] = total;
+    }
+    for (double& c : cumulative_)
+        c /= total;
+    cumulative_.back() = 1.0;
+}
+
+
+error_type CorpusGenerator::write(const std::filesystem::path& path) const {
+    std::ofstream out(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!out.is_open())
+        return UNABLE_TO_OPEN_FILE_FOR_WRITING;
+
+    // a different stream of numbers than the one that made the vocabulary
+    Random random(spec_.seed ^ 0xD1B54A32D192ED03ULL);
+    std::string buffer;
+    buffer.reserve((1 << 20) + 1024);
+    std::uint64_t written = 0;
+
+    while (written + buffer.size() < spec_.bytes) {
+        for (unsigned i = 0; i < kWordsPerLine; ++i) {
+            const auto rank = static_cast<std::size_t>(
+                std::upper_bound(cumulative_.begin(), cumulative_.end(), random.unit()) - cumulative_.begin());
+            const std::string& word = words_[std::min(rank, words_.size() - 1)];
+
+            if (i > 0)
+                buffer += ' ';
+            buffer += word;
+            if (i == 0)
+                buffer[buffer.size() - word.size()] = static_cast<char>(word[0] - 'a' + 'A');
+        }
+        buffer += ".\n";
+
+        if (buffer.size() >= (1 << 20)) {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            written += buffer.size();
+            buffer.clear();
+        }
+    }
+
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.close();
+    return out.fail() ? FAILED_TO_WRITE_FILE : NO_ERROR;
+}
+
+
+std::string CorpusGenerator::fileName() const {
+    char exponent[32];
+    std::snprintf(exponent, sizeof exponent, "%.2f", spec_.zipfExponent);
+    return "zipf_" + std::to_string(spec_.bytes) + "_v" + std::to_string(spec_.vocabulary) + "_s" + exponent +
+           "_l" + std::to_string(spec_.minWordLength) + "-" + std::to_string(spec_.maxWordLength) +
+           (spec_.shortWordsFirst ? "short" : "") + "_seed" + std::to_string(spec_.seed) + ".txt";
+}
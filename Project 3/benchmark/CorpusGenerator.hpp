@@ -0,0 +1,45 @@
+#ifndef PROJECT_3_CORPUSGENERATOR_HPP
+#define PROJECT_3_CORPUSGENERATOR_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+
+// What a synthetic corpus looks like. The same spec always gives the same bytes, on any platform
+// (the generator uses its own random numbers, not <random>'s implementation-defined distributions).
+struct CorpusSpec {
+    std::uint64_t bytes = 1 << 20;  // stop at the first line break at or past this size
+    std::size_t vocabulary = 10000; // distinct words
+    double zipfExponent = 1.0;      // the word of rank r turns up with probability proportional to 1 / r^s
+    unsigned minWordLength = 2;     // each vocabulary word's length is uniform in [min, max]...
+    unsigned maxWordLength = 12;
+    bool shortWordsFirst = false;   // ...and with this, sorted so the most frequent words are the shortest (like English)
+    std::uint64_t seed = 1;
+};
+
+// Writes text the Scanner tokenizes back into exactly the sampled words: lines of 16 words separated by spaces,
+// the first one capitalized and a period at the end (so the lowercasing and separator paths get exercised too).
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(const CorpusSpec& spec);
+
+    // Streams the corpus to 'path' (nothing is held in memory but the vocabulary, so any size works).
+    error_type write(const std::filesystem::path& path) const;
+
+    // A file name that identifies the spec, e.g. "zipf_1048576_v10000_s1.00_l2-12_seed1.txt".
+    [[nodiscard]] std::string fileName() const;
+
+    [[nodiscard]] const std::vector<std::string>& vocabulary() const noexcept { return words_; }
+
+private:
+    CorpusSpec spec_;
+    std::vector<std::string> words_; // by rank
+    std::vector<double> cumulative_; // cumulative_[r] = P(rank <= r), for sampling by binary search
+};
+
+
+#endif //PROJECT_3_CORPUSGENERATOR_HPP
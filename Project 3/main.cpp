@@ -3,105 +3,488 @@
 #include <filesystem>
 #include <string>
 #include <vector>
-#include <random>
 #include <algorithm>
 #include <iomanip>
+#include <chrono>
+#include <optional>
+#include <sstream>
+#include <numeric>
 
 #include "Scanner.hpp"
 #include "BinSearchTree.hpp"
+#include "HashCounter.hpp"
 #include "PriorityQueue.hpp"
 #include "HuffmanTree.hpp"
+#include "HuffmanDecoder.hpp"
+#include "AdaptiveHuffman.hpp"
+#include "BlockContainer.hpp"
 #include "TreeNode.hpp"
+#include "NodeArena.hpp"
+#include "Vocabulary.hpp"
+#include "MappedFile.hpp"
+#include "SyncIndex.hpp"
+#include "OutputBuffer.hpp"
+#include "Parallel.hpp"
+#include "Profiler.hpp"
 #include "utils.hpp"
 
 
-int main(int argc, char *argv[]) {
-
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <filename>\n";
-        return 1;
+// Command-line switches. With none given, every stage runs exactly as before.
+struct Options {
+    std::string inputFileName;
+    bool batch = false;     // --batch: inputFileName is a directory (every .txt in it) or a file listing one input per line
+    unsigned batchThreads = 0; // --batch-threads=N: files processed at once in a batch (0 = one per core)
+    bool useMmap = false;   // --mmap: tokenize from a memory-mapped view of the input
+    ScanKernel kernel = ScanKernel::Auto; // --simd=<auto|scalar|sse2|avx2>: word finder for --mmap
+    unsigned scanThreads = 1;             // --threads=N: tokenize --mmap input on N threads (0 = all cores)
+    bool streaming = false; // --stream: two passes over the file instead of keeping every token in memory
+    bool interning = false; // --intern: tokens become word ids; count and encode by array index
+    bool adaptive = false;  // --adaptive: one pass, .code written as an adaptive Huffman stream while tokenizing
+    bool bstDepths = false; // --bst-depths: also print how many BST nodes sit at each depth
+    CounterBackend counter = CounterBackend::Bst; // --counter=<bst|hash>: what counts the words (--intern counts by id)
+    HuffmanBuild huffmanBuild = HuffmanBuild::PriorityQueue; // --huffman=<pq|two-queue>
+    CodeFormat codeFormat = CodeFormat::Ascii; // --binary: write .code as packed bits instead of '0'/'1' text
+    unsigned encodeThreads = 1; // --encode-threads=N: encode .code on N threads (0 = all cores; not with --stream)
+    unsigned decodeThreads = 0; // --decode-threads=N: --verify decodes from the sync points on N threads (0 = all cores)
+    std::uint64_t blockTokens = 0; // --block-size=N: one pass, .code written as blocks of N tokens with their own codebooks
+    std::uint64_t syncEvery = 0; // --sync-every=N: write a .idx sidecar with a sync point every N tokens (0 = none)
+    bool stats = false;     // --stats: also print bits per token next to the entropy of the word frequencies
+    bool profile = false;   // --profile: per-stage wall/CPU time, peak RSS growth and allocations, as JSON lines on stdout
+    std::string profileTrace; // --profile-trace=FILE: the same stages as a Chrome trace-event file (implies --profile)
+    bool verify = false;    // --verify: decode .code with .hdr afterwards, check it against .tokens, report decode speed
+    bool canonical = false; // --canonical: canonical codes and a lengths-only .hdr
+    unsigned maxCodeLength = 0; // --max-code-length=L: no code longer than L bits (implies --canonical; 0 = no limit)
+};
+
+static bool parseOptions(int argc, char *argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (arg == "--mmap")
+            options.useMmap = true;
+        else if (arg == "--stream")
+            options.streaming = true;
+        else if (arg == "--intern")
+            options.interning = true;
+        else if (arg == "--adaptive")
+            options.adaptive = true;
+        else if (arg == "--batch")
+            options.batch = true;
+        else if (arg == "--bst-depths")
+            options.bstDepths = true;
+        else if (arg == "--canonical")
+            options.canonical = true;
+        else if (arg == "--stats")
+            options.stats = true;
+        else if (arg == "--verify")
+            options.verify = true;
+        else if (arg == "--profile")
+            options.profile = true;
+        else if (arg.rfind("--profile-trace=", 0) == 0) {
+            options.profileTrace = arg.substr(16);
+            options.profile = true;
+            if (options.profileTrace.empty())
+                return false;
+        }
+        else if (arg == "--binary")
+            options.codeFormat = CodeFormat::Binary;
+        else if (arg == "--counter=bst")
+            options.counter = CounterBackend::Bst;
+        else if (arg == "--counter=hash")
+            options.counter = CounterBackend::Hash;
+        else if (arg == "--huffman=pq")
+            options.huffmanBuild = HuffmanBuild::PriorityQueue;
+        else if (arg == "--huffman=two-queue")
+            options.huffmanBuild = HuffmanBuild::TwoQueue;
+        else if (arg.rfind("--simd=", 0) == 0) {
+            const std::string kind = arg.substr(7);
+            if (kind == "auto")
+                options.kernel = ScanKernel::Auto;
+            else if (kind == "scalar")
+                options.kernel = ScanKernel::Scalar;
+            else if (kind == "sse2")
+                options.kernel = ScanKernel::SSE2;
+            else if (kind == "avx2")
+                options.kernel = ScanKernel::AVX2;
+            else
+                return false;
+            options.useMmap = true;
+        }
+        else if (arg.rfind("--max-code-length=", 0) == 0) {
+            try {
+                options.maxCodeLength = static_cast<unsigned>(std::stoul(arg.substr(18)));
+            } catch (const std::exception&) {
+                return false;
+            }
+            if (options.maxCodeLength == 0 || options.maxCodeLength > Codebook::kMaxCodeLength)
+                return false;
+            options.canonical = true;
+        }
+        else if (arg.rfind("--encode-threads=", 0) == 0) {
+            try {
+                options.encodeThreads = static_cast<unsigned>(std::stoul(arg.substr(17)));
+            } catch (const std::exception&) {
+                return false;
+            }
+        }
+        else if (arg.rfind("--decode-threads=", 0) == 0) {
+            try {
+                options.decodeThreads = static_cast<unsigned>(std::stoul(arg.substr(17)));
+            } catch (const std::exception&) {
+                return false;
+            }
+        }
+        else if (arg.rfind("--batch-threads=", 0) == 0) {
+            try {
+                options.batchThreads = static_cast<unsigned>(std::stoul(arg.substr(16)));
+            } catch (const std::exception&) {
+                return false;
+            }
+            options.batch = true;
+        }
+        else if (arg.rfind("--block-size=", 0) == 0) {
+            try {
+                options.blockTokens = std::stoull(arg.substr(13));
+            } catch (const std::exception&) {
+                return false;
+            }
+            if (options.blockTokens == 0)
+                return false;
+        }
+        else if (arg.rfind("--sync-every=", 0) == 0) {
+            try {
+                options.syncEvery = std::stoull(arg.substr(13));
+            } catch (const std::exception&) {
+                return false;
+            }
+        }
+        else if (arg.rfind("--threads=", 0) == 0) {
+            try {
+                options.scanThreads = static_cast<unsigned>(std::stoul(arg.substr(10)));
+            } catch (const std::exception&) {
+                return false;
+            }
+            options.useMmap = true;
+        }
+        else if (arg.rfind("--", 0) == 0 || !options.inputFileName.empty())
+            return false;
+        else
+            options.inputFileName = arg;
     }
 
+    // streaming never keeps a token list around, interned or not
+    if (options.streaming && options.interning)
+        return false;
+
+    // ...and it encodes each token as the second pass reads it, so there are no slices to hand to other threads
+    if (options.streaming && options.encodeThreads != 1)
+        return false;
+
+    // adaptive mode is its own single pass: no token list, no static codes to split across threads or index
+    if (options.adaptive && (options.streaming || options.interning || options.encodeThreads != 1 || options.syncEvery != 0))
+        return false;
+
+    // so is block mode (where --encode-threads is how many blocks are fitted and encoded at once)
+    if (options.blockTokens != 0 && (options.streaming || options.interning || options.adaptive || options.syncEvery != 0))
+        return false;
+
+    // the hash counter has no tree to measure, and --intern doesn't count through either backend
+    if (options.counter == CounterBackend::Hash && (options.bstDepths || options.interning))
+        return false;
+
+    // one trace file per run; a batch has many runs
+    if (!options.profileTrace.empty() && options.batch)
+        return false;
+
+    // the profile's counters are process-wide, so files running side by side would be charged for each other's work
+    if (options.profile && options.batch && options.batchThreads != 1)
+        return false;
+
+    return !options.inputFileName.empty();
+}
+
+
+// A single run stops the whole process at its first error, as always; in a batch only that file's run stops.
+static int stopOnError(const Options& options, error_type error, const std::string& entityName) {
+    if (!options.batch)
+        exitOnError(error, entityName);
+
+    std::cerr << errorMessage(error, entityName) << '\n';
+    return static_cast<int>(error);
+}
+
+
+// Every step for one input file; what main used to print goes to 'out'. Returns the exit code.
+static int processFile(const Options& options, std::ostream& out) {
     const std::string dirName = "input_output";
-    const std::string inputFileName = argv[1];
-    const std::string inputFileBaseName = baseNameWithoutTxt(inputFileName);
+    const std::string& inputFileName = options.inputFileName;
+    // --adaptive can also take a pipe while it's being written to ("-" for stdin), encoding each line as it arrives
+    const bool liveInput = options.adaptive && isLiveInput(inputFileName);
+    const std::string inputFileBaseName = inputFileName == "-" ? "stdin" : baseNameWithoutTxt(inputFileName);
 
     // Build paths to output files
     const std::string wordTokensFileName = dirName + "/" + inputFileBaseName + ".tokens";
     const std::string freqFileName = dirName + "/" + inputFileBaseName + ".freq";
     const std::string hdrFileName = dirName + "/" + inputFileBaseName + ".hdr";
     const std::string codeFileName = dirName + "/" + inputFileBaseName + ".code";
+    const std::string indexFileName = dirName + "/" + inputFileBaseName + ".idx";
 
-    // Validate input file, directory, and output files
-    if (error_type status; (status = regularFileExistsAndIsAvailable(inputFileName)) != NO_ERROR)
-        exitOnError(status, inputFileName);
+    // Validate input file, directory, and output files (a pipe can only be opened once, so it's left for the scanner)
+    if (error_type status; !liveInput && (status = regularFileExistsAndIsAvailable(inputFileName)) != NO_ERROR)
+        return stopOnError(options, status, inputFileName);
 
     if (error_type status; (status = directoryExists(dirName)) != NO_ERROR)
-        exitOnError(status, dirName);
+        return stopOnError(options, status, dirName);
 
     if (error_type status; (status = canOpenForWriting(wordTokensFileName)) != NO_ERROR)
-        exitOnError(status, wordTokensFileName);
+        return stopOnError(options, status, wordTokensFileName);
 
     if (error_type status; (status = canOpenForWriting(freqFileName)) != NO_ERROR)
-        exitOnError(status, freqFileName);
+        return stopOnError(options, status, freqFileName);
 
     if (error_type status; (status = canOpenForWriting(hdrFileName)) != NO_ERROR)
-        exitOnError(status, hdrFileName);
+        return stopOnError(options, status, hdrFileName);
 
     if (error_type status; (status = canOpenForWriting(codeFileName)) != NO_ERROR)
-        exitOnError(status, codeFileName);
+        return stopOnError(options, status, codeFileName);
+
+    if (options.syncEvery != 0) {
+        if (error_type status; (status = canOpenForWriting(indexFileName)) != NO_ERROR)
+            return stopOnError(options, status, indexFileName);
+    }
+
+    // --profile: each step below starts a stage (a disabled profiler ignores them)
+    Profiler profiler(options.profile);
 
 
     // ========== STEP 1: TOKENIZE (Scanner) ==========
     std::vector<std::string> tokens;
     Scanner scanner(inputFileName);
+    scanner.setKernel(options.kernel);
 
-    if (error_type status; (status = scanner.tokenize(tokens)) != NO_ERROR)
-        exitOnError(status, inputFileName);
+    // what counts the words: the BST, or the flat hash table with --counter=hash
+    BinSearchTree bst;
+    HashCounter hashCounter;
+    WordCounter& counter = options.counter == CounterBackend::Hash ? static_cast<WordCounter&>(hashCounter) : bst;
+    size_t totalTokens = 0;
+    size_t totalLetters = 0;
 
-    // Write tokens to .tokens file
-    if (error_type status; (status = writeVectorToFile(wordTokensFileName, tokens)) != NO_ERROR)
-        exitOnError(status, wordTokensFileName);
+    // used by --intern instead of 'tokens' and the BST
+    Vocabulary vocab;
+    std::vector<std::uint32_t> ids;
+    std::vector<size_t> idCounts;
+
+    // --adaptive and --block-size write .code during the pass below, so it's timed on its own
+    const bool onePass = options.adaptive || options.blockTokens != 0;
+    std::chrono::duration<double> onePassSeconds{};
+    std::uint64_t onePassBits = 0;   // everything in .code: codes, plus new words' spellings or the block codebooks
+    std::uint64_t blocks = 0;
+    std::uint64_t reusedBlocks = 0;
+    // live input: from a line's first token being handed over to its code being flushed out to .code
+    std::chrono::duration<double> totalLatency{};
+    std::chrono::duration<double> maxLatency{};
+    std::uint64_t latencyLines = 0;
+
+    if (onePass) {
+        // ========== STEPS 1-3 AND 8 (one pass): WRITES .tokens, COUNTS AND ENCODES ==========
+        profiler.stage("tokenize+count+encode");
+        // the counts are only for the .freq/.hdr files and the report; .code doesn't depend on them
+        std::ofstream tokensFile(wordTokensFileName, std::ios::out | std::ios::trunc);
+        if (!tokensFile.is_open())
+            return stopOnError(options, UNABLE_TO_OPEN_FILE_FOR_WRITING, wordTokensFileName);
+
+        std::ofstream codeFile(codeFileName, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!codeFile.is_open())
+            return stopOnError(options, UNABLE_TO_OPEN_FILE_FOR_WRITING, codeFileName);
+
+        std::optional<AdaptiveHuffmanEncoder> adaptiveEncoder;
+        std::optional<BlockEncoder> blockEncoder;
+        if (options.adaptive)
+            adaptiveEncoder.emplace(codeFile);
+        else
+            blockEncoder.emplace(codeFile, options.blockTokens, options.encodeThreads);
+        error_type encodeStatus = NO_ERROR;
+        const auto start = std::chrono::steady_clock::now();
+
+        std::optional<std::chrono::steady_clock::time_point> lineStart;
+        const auto visit = [&](const std::string_view token) {
+            if (liveInput && !lineStart)
+                lineStart = std::chrono::steady_clock::now();
+            tokensFile << token << '\n';
+            counter.insert(token);
+            totalTokens++;
+            totalLetters += token.length();
+            if (encodeStatus == NO_ERROR)
+                encodeStatus = adaptiveEncoder ? adaptiveEncoder->put(token) : blockEncoder->put(token);
+        };
+
+        // a live stream's code goes out at the end of every line (all but the last partial byte), not per 64 KB
+        error_type status = !liveInput ? scanner.forEachToken(visit) : scanner.forEachTokenByLine(visit, [&] {
+            if (!lineStart)
+                return;
+            adaptiveEncoder->flush();
+            const std::chrono::duration<double> latency = std::chrono::steady_clock::now() - *lineStart;
+            totalLatency += latency;
+            maxLatency = std::max(maxLatency, latency);
+            latencyLines++;
+            lineStart.reset();
+        });
+        if (status != NO_ERROR)
+            return stopOnError(options, status, inputFileName);
+
+        if (encodeStatus == NO_ERROR)
+            encodeStatus = adaptiveEncoder ? adaptiveEncoder->finish() : blockEncoder->finish();
+        if (encodeStatus != NO_ERROR)
+            return stopOnError(options, encodeStatus, codeFileName);
+        onePassSeconds = std::chrono::steady_clock::now() - start;
+
+        if (adaptiveEncoder)
+            onePassBits = adaptiveEncoder->bitCount();
+        else {
+            onePassBits = blockEncoder->codeBits() + 8 * blockEncoder->codebookBytes();
+            blocks = blockEncoder->blockCount();
+            reusedBlocks = blockEncoder->reusedCount();
+        }
 
-    // Save original token count before shuffling
-    size_t totalTokens = tokens.size();
+        tokensFile.close();
+        codeFile.close();
+        if (tokensFile.fail() || codeFile.fail()) {
+            std::cerr << "Error: failed while writing to " << (tokensFile.fail() ? wordTokensFileName : codeFileName) << "\n";
+            return 1;
+        }
+    }
+    else if (options.streaming) {
+        // ========== STEPS 1-3 (streaming): ONE PASS THAT WRITES .tokens AND COUNTS ==========
+        profiler.stage("tokenize+count");
+        std::ofstream tokensFile(wordTokensFileName, std::ios::out | std::ios::trunc);
+        if (!tokensFile.is_open())
+            return stopOnError(options, UNABLE_TO_OPEN_FILE_FOR_WRITING, wordTokensFileName);
+
+        error_type status = scanner.forEachToken([&](const std::string_view token) {
+            tokensFile << token << '\n';
+            counter.insert(token);
+            totalTokens++;
+            totalLetters += token.length();
+        });
+        if (status != NO_ERROR)
+            return stopOnError(options, status, inputFileName);
+
+        tokensFile.close();
+        if (tokensFile.fail()) {
+            std::cerr << "Error: failed while writing to " << wordTokensFileName << "\n";
+            return 1;
+        }
+    }
+    else if (options.interning) {
+        // ========== STEPS 1-3 (interned): TOKENIZE TO IDS, COUNT BY ARRAY INDEX ==========
+        profiler.stage("tokenize+count");
+        if (error_type status; (status = scanner.tokenizeIds(vocab, ids)) != NO_ERROR)
+            return stopOnError(options, status, inputFileName);
+
+        // Write tokens to .tokens file (the only place the per-token string form comes back)
+        std::ofstream tokensFile(wordTokensFileName, std::ios::out | std::ios::trunc);
+        if (!tokensFile.is_open())
+            return stopOnError(options, UNABLE_TO_OPEN_FILE_FOR_WRITING, wordTokensFileName);
+
+        for (const std::uint32_t id : ids)
+            tokensFile << vocab.word(id) << '\n';
+
+        tokensFile.close();
+        if (tokensFile.fail()) {
+            std::cerr << "Error: failed while writing to " << wordTokensFileName << "\n";
+            return 1;
+        }
 
-    // Calculate total letters in input words
-    size_t totalLetters = 0;
-    for (const auto& token : tokens) {
-        totalLetters += token.length();
+        // counting is just an increment per token
+        idCounts.assign(vocab.size(), 0);
+        for (const std::uint32_t id : ids)
+            idCounts[id]++;
+
+        totalTokens = ids.size();
+        for (std::uint32_t id = 0; id < vocab.size(); ++id)
+            totalLetters += idCounts[id] * vocab.word(id).length();
     }
+    else {
+        profiler.stage("tokenize");
+        if (options.useMmap) {
+            // tokens come back as views into the mapped file; lowercase each one as we keep it
+            std::vector<std::string_view> views;
+            scanner.setThreads(options.scanThreads);
+            if (error_type status; (status = scanner.tokenizeViews(views)) != NO_ERROR)
+                return stopOnError(options, status, inputFileName);
+
+            scanner.materialize(views, tokens);
+        }
+        else if (error_type status; (status = scanner.tokenize(tokens)) != NO_ERROR)
+            return stopOnError(options, status, inputFileName);
 
-    // ========== STEP 2: SHUFFLE TOKENS (for balanced BST) ==========
-    // Use fixed seed for deterministic results
-    std::mt19937 rng(0xC0FFEE);
-    std::shuffle(tokens.begin(), tokens.end(), rng);
+        // Write tokens to .tokens file
+        if (error_type status; (status = writeVectorToFile(wordTokensFileName, tokens)) != NO_ERROR)
+            return stopOnError(options, status, wordTokensFileName);
 
+        totalTokens = tokens.size();
 
-    // ========== STEP 3: BUILD BST (count frequencies) ==========
-    BinSearchTree bst;
-    bst.bulkInsert(tokens);
+        // Calculate total letters in input words
+        for (const auto& token : tokens) {
+            totalLetters += token.length();
+        }
+
+        // ========== STEPS 2-3: BUILD BST (count frequencies) ==========
+        // The BST balances itself, so the tokens go in as-is (no shuffle pass needed)
+        profiler.stage(options.counter == CounterBackend::Hash ? "hash count" : "bst build");
+        counter.bulkInsert(tokens);
+    }
 
-    // Get the in-order traversal (lexicographically sorted by word)
+    // Get the (word, count) list sorted lexicographically by word
     std::vector<std::pair<std::string, int>> frequencies;
-    bst.inorderCollect(frequencies);
+    if (options.interning) {
+        frequencies.reserve(vocab.size());
+        for (std::uint32_t id = 0; id < vocab.size(); ++id)
+            frequencies.emplace_back(vocab.word(id), static_cast<int>(idCounts[id]));
+        std::sort(frequencies.begin(), frequencies.end());
+    }
+    else
+        counter.sortedCounts(frequencies);
 
 
     // ========== STEP 4: PRINT BST METRICS to stdout ==========
-    std::cout << "Total tokens: " << totalTokens << '\n';
-    std::cout << "Distinct words: " << bst.size() << '\n';
-    std::cout << "BST height: " << bst.height() << '\n';
-    std::cout << "Min frequency: " << bst.minFrequency() << '\n';
-    std::cout << "Max frequency: " << bst.maxFrequency() << '\n';
+    profiler.stage("metrics");
+    out << "Total tokens: " << totalTokens << '\n';
+    if (options.interning) {
+        // there's no BST in this mode, so there's no height to report
+        out << "Distinct words: " << vocab.size() << '\n';
+        out << "Min frequency: " << (idCounts.empty() ? 0 : *std::min_element(idCounts.begin(), idCounts.end())) << '\n';
+        out << "Max frequency: " << (idCounts.empty() ? 0 : *std::max_element(idCounts.begin(), idCounts.end())) << '\n';
+    }
+    else {
+        out << "Distinct words: " << counter.size() << '\n';
+        // only the BST has a height
+        if (options.counter == CounterBackend::Bst)
+            out << "BST height: " << bst.height() << '\n';
+        out << "Min frequency: " << counter.minFrequency() << '\n';
+        out << "Max frequency: " << counter.maxFrequency() << '\n';
+
+        if (options.bstDepths) {
+            std::vector<std::size_t> depths;
+            bst.depthHistogram(depths);
+            out << "BST nodes per depth:";
+            for (const std::size_t nodes : depths)
+                out << ' ' << nodes;
+            out << '\n';
+        }
+    }
 
 
     // ========== STEP 5: WRITE .freq FILE ==========
+    profiler.stage(".freq");
     // Create temporary nodes JUST for the priority queue (for sorting)
+    // They come from their own arena, which frees them all at once when it goes out of scope
+    NodeArena freqArena;
     std::vector<TreeNode*> tempLeavesForFreq;
     tempLeavesForFreq.reserve(frequencies.size());
 
     for (const auto& [word, count] : frequencies) {
-        tempLeavesForFreq.push_back(new TreeNode(word, static_cast<size_t>(count)));
+        tempLeavesForFreq.push_back(freqArena.make(word, static_cast<size_t>(count)));
     }
 
     // Create priority queue (will sort by count desc, word asc)
@@ -122,33 +505,59 @@ int main(int argc, char *argv[]) {
     std::ofstream freqFile(freqFileName);
     if (!freqFile.is_open()) {
         std::cerr << "Error: Unable to open " << freqFileName << " for writing\n";
-
-        // Clean up temp nodes
-        for (TreeNode* node : tempLeavesForFreq) {
-            delete node;
-        }
         return 1;
     }
 
     // Write to file: count word (right-justified count with width 10)
+    OutputBuffer freqOut(freqFile);
     for (const TreeNode* node : sortedNodes) {
-        freqFile << std::setw(10) << node->count << ' ' << node->word << '\n';
+        freqOut.putRightAligned(node->count, 10);
+        freqOut.put(' ');
+        freqOut.write(node->word);
+        freqOut.put('\n');
     }
 
+    if (error_type status; (status = freqOut.flush()) != NO_ERROR)
+        return stopOnError(options, status, freqFileName);
     freqFile.close();
 
-    // Clean up the temporary nodes we created for .freq file
-    for (TreeNode* node : tempLeavesForFreq) {
-        delete node;
-    }
-
 
     // ========== STEP 6: BUILD HUFFMAN TREE ==========
+    profiler.stage("huffman build");
     // buildFromCounts creates its OWN nodes and takes ownership of them
-    HuffmanTree huffmanTree = HuffmanTree::buildFromCounts(frequencies);
+    HuffmanTree huffmanTree = HuffmanTree::buildFromCounts(frequencies, options.huffmanBuild);
+    if (options.maxCodeLength != 0) {
+        // cap the code lengths, and report what that costs against the unconstrained tree
+        const unsigned treeLongest = huffmanTree.treeHeight();
+        const std::uint64_t huffmanBits = huffmanTree.treeEncodedBits();
+        if (!huffmanTree.limitCodeLengths(options.maxCodeLength)) {
+            std::cerr << "Error: " << frequencies.size() << " distinct words don't fit in codes of at most "
+                      << options.maxCodeLength << " bits\n";
+            return 1;
+        }
+
+        const std::uint64_t limitedBits = huffmanTree.encodedBits();
+        out << "Longest code: " << huffmanTree.longestCode() << " bits (limit " << options.maxCodeLength
+            << ", unconstrained Huffman " << treeLongest << ")\n";
+        out << "Bits lost to the limit: " << (limitedBits - huffmanBits) << " (" << std::fixed << std::setprecision(4)
+            << (huffmanBits == 0 ? 0.0 : 100.0 * static_cast<double>(limitedBits - huffmanBits) / static_cast<double>(huffmanBits))
+            << "%)\n" << std::defaultfloat;
+    }
+    else if (options.canonical && !huffmanTree.makeCanonical()) {
+        // the tree's codes are too long to pack; capping them at the longest that fits gives canonical codes anyway
+        std::cerr << "Note: some Huffman codes are longer than " << Codebook::kMaxCodeLength
+                  << " bits, so --canonical caps them at that length (as --max-code-length="
+                  << Codebook::kMaxCodeLength << " would)\n";
+        if (!huffmanTree.limitCodeLengths(Codebook::kMaxCodeLength)) {
+            std::cerr << "Error: " << frequencies.size() << " distinct words don't fit in codes of at most "
+                      << Codebook::kMaxCodeLength << " bits\n";
+            return 1;
+        }
+    }
 
 
     // ========== STEP 7: WRITE .hdr FILE ==========
+    profiler.stage(".hdr");
     std::ofstream hdrFile(hdrFileName);
     if (!hdrFile.is_open()) {
         std::cerr << "Error: Unable to open " << hdrFileName << " for writing\n";
@@ -156,45 +565,348 @@ int main(int argc, char *argv[]) {
     }
 
     if (error_type status; (status = huffmanTree.writeHeader(hdrFile)) != NO_ERROR) {
-        exitOnError(status, hdrFileName);
+        return stopOnError(options, status, hdrFileName);
     }
 
     hdrFile.close();
 
 
     // ========== STEP 8: ENCODE TOKENS AND WRITE .code FILE ==========
-    std::ofstream codeFile(codeFileName);
-    if (!codeFile.is_open()) {
-        std::cerr << "Error: Unable to open " << codeFileName << " for writing\n";
-        return 1;
-    }
+    // filled in while encoding when --sync-every is given
+    SyncIndex syncIndex(options.syncEvery);
+    SyncIndex* const index = options.syncEvery != 0 ? &syncIndex : nullptr;
+
+    // (--adaptive and --block-size already wrote .code during their pass)
+    if (!onePass) {
+        profiler.stage("encode");
+        const bool binaryCode = options.codeFormat == CodeFormat::Binary;
+        std::ofstream codeFile(codeFileName, binaryCode ? std::ios::out | std::ios::trunc | std::ios::binary
+                                                        : std::ios::out | std::ios::trunc);
+        if (!codeFile.is_open()) {
+            std::cerr << "Error: Unable to open " << codeFileName << " for writing\n";
+            return 1;
+        }
 
-    if (error_type status; (status = huffmanTree.encode(tokens, codeFile, 80)) != NO_ERROR) {
-        exitOnError(status, codeFileName);
-    }
+        if (options.streaming) {
+            // second pass over the input: encode each token as the scanner hands it over
+            HuffmanTree::Encoder encoder(huffmanTree, codeFile, 80, options.codeFormat);
+            encoder.trackSyncPoints(index);
+            error_type encodeStatus = NO_ERROR;
+
+            error_type status = scanner.forEachToken([&](const std::string_view token) {
+                if (encodeStatus == NO_ERROR)
+                    encodeStatus = encoder.put(token);
+            });
+            if (status != NO_ERROR)
+                return stopOnError(options, status, inputFileName);
+
+            if (encodeStatus == NO_ERROR)
+                encodeStatus = encoder.finish();
+            if (encodeStatus != NO_ERROR)
+                return stopOnError(options, encodeStatus, codeFileName);
+        }
+        else if (options.encodeThreads != 1) {
+            // same bytes as below, just split across threads
+            error_type status = options.interning
+                ? huffmanTree.encodeParallel(ids, vocab, codeFile, options.encodeThreads, 80, options.codeFormat, index)
+                : huffmanTree.encodeParallel(tokens, codeFile, options.encodeThreads, 80, options.codeFormat, index);
+            if (status != NO_ERROR)
+                return stopOnError(options, status, codeFileName);
+        }
+        else if (options.interning) {
+            if (error_type status; (status = huffmanTree.encode(ids, vocab, codeFile, 80, options.codeFormat, index)) != NO_ERROR)
+                return stopOnError(options, status, codeFileName);
+        }
+        else if (error_type status; (status = huffmanTree.encode(tokens, codeFile, 80, options.codeFormat, index)) != NO_ERROR) {
+            return stopOnError(options, status, codeFileName);
+        }
 
-    codeFile.close();
+        codeFile.close();
+
+        if (index != nullptr) {
+            // the sidecar index, and what it costs next to the .code file
+            std::ofstream indexFile(indexFileName, std::ios::out | std::ios::trunc | std::ios::binary);
+            if (!indexFile.is_open())
+                return stopOnError(options, UNABLE_TO_OPEN_FILE_FOR_WRITING, indexFileName);
+            if (error_type status; (status = syncIndex.write(indexFile)) != NO_ERROR)
+                return stopOnError(options, status, indexFileName);
+            indexFile.close();
+
+            const auto codeBytes = static_cast<double>(std::filesystem::file_size(codeFileName));
+            out << "Sync index: " << syncIndex.size() << " points every " << syncIndex.interval() << " tokens, "
+                << syncIndex.fileBytes() << " bytes (" << std::fixed << std::setprecision(2)
+                << (codeBytes > 0 ? 100.0 * static_cast<double>(syncIndex.fileBytes()) / codeBytes : 0.0)
+                << "% of .code)\n" << std::defaultfloat;
+        }
+    }
 
 
     // ========== STEP 9: CALCULATE ENCODED BIT COUNT ==========
-    // Reopen the code file to count bits
-    std::ifstream codeFileForCount(codeFileName);
-    size_t totalBits = 0;
-    char ch;
-    while (codeFileForCount.get(ch)) {
-        if (ch == '0' || ch == '1') {
-            totalBits++;
+    profiler.stage("bit count");
+    // Every token costs exactly its code's length, so the total comes from the counts and the codebook
+    // (no need to read .code back)
+    const EncodingStats encodingStats = huffmanTree.encodingStats();
+    const std::uint64_t totalBits = encodingStats.totalBits;
+
+    out << "Total letters in input words: " << totalLetters << '\n';
+    if (onePass) {
+        // what actually went into .code (new words' spellings or the block codebooks included, since there's no .hdr
+        // to carry them), next to what the static codes would have taken
+        const char* const mode = options.adaptive ? "adaptive" : "blocks";
+        out << "Total bits in encoded words: " << onePassBits << '\n';
+        if (options.blockTokens != 0)
+            out << "Blocks: " << blocks << " of up to " << options.blockTokens << " tokens, " << reusedBlocks
+                << " reusing the previous codebook\n";
+        const std::uint64_t staticBits = totalBits + 8 * std::filesystem::file_size(hdrFileName);
+        out << "Static two-pass Huffman bits: " << totalBits << " + " << (staticBits - totalBits) << " for .hdr ("
+            << mode << ": " << std::fixed << std::setprecision(2) << std::showpos
+            << (staticBits == 0 ? 0.0 : 100.0 * (static_cast<double>(onePassBits) - static_cast<double>(staticBits)) / static_cast<double>(staticBits))
+            << std::noshowpos << "%)\n";
+        out << (options.adaptive ? "Adaptive" : "Block") << " encode speed: " << std::setprecision(1)
+            << (onePassSeconds.count() > 0 ? static_cast<double>(totalLetters + totalTokens) / 1e6 / onePassSeconds.count() : 0.0)
+            << " MB/s of tokens (one pass, tokenizing included)\n" << std::defaultfloat;
+        if (liveInput) {
+            out << "Latency (line's first token to its code flushed): " << std::fixed << std::setprecision(1)
+                << (latencyLines > 0 ? totalLatency.count() * 1e6 / static_cast<double>(latencyLines) : 0.0)
+                << " us average, " << maxLatency.count() * 1e6 << " us max over " << latencyLines << " lines\n"
+                << std::defaultfloat;
+        }
+    }
+    else
+        out << "Total bits in encoded words: " << totalBits << '\n';
+
+    if (options.stats) {
+        out << std::fixed << std::setprecision(4);
+        out << "Average bits per token: " << encodingStats.averageBits << '\n';
+        out << "Entropy (bits per token): " << encodingStats.entropyBits << '\n';
+        out << "Gap to entropy (bits per token): " << encodingStats.gapBits << '\n';
+        out << std::defaultfloat;
+    }
+
+
+    // ========== STEP 10: DECODE AND VERIFY (--verify) ==========
+    if (options.verify)
+        profiler.stage("verify");
+
+    if (options.verify && onePass) {
+        // an adaptive stream or a block container carries everything it needs: no .hdr
+        MappedFile codeBytes;
+        if (error_type status; (status = codeBytes.open(codeFileName)) != NO_ERROR)
+            return stopOnError(options, status, codeFileName);
+
+        std::string decoded;
+        const auto start = std::chrono::steady_clock::now();
+        const auto* data = reinterpret_cast<const unsigned char*>(codeBytes.view().data());
+        error_type decodeStatus = options.adaptive ? decodeAdaptiveHuffman(data, codeBytes.view().size(), decoded)
+                                                   : decodeBlocks(data, codeBytes.view().size(), decoded);
+        if (decodeStatus != NO_ERROR)
+            return stopOnError(options, decodeStatus, codeFileName);
+        const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+        MappedFile tokensFile;
+        if (error_type status; (status = tokensFile.open(wordTokensFileName)) != NO_ERROR)
+            return stopOnError(options, status, wordTokensFileName);
+        const bool matches = tokensFile.view() == decoded;
+
+        out << "Decoded matches .tokens: " << (matches ? "yes" : "NO") << '\n';
+        out << "Decode speed: " << std::fixed << std::setprecision(1)
+            << (seconds.count() > 0 ? static_cast<double>(decoded.size()) / 1e6 / seconds.count() : 0.0)
+            << " MB/s (" << decoded.size() << " bytes of text)\n" << std::defaultfloat;
+        if (!matches)
+            return 1;
+    }
+    else if (options.verify) {
+        // everything comes back off disk, exactly as a downstream reader would see it
+        std::ifstream hdrFileForDecode(hdrFileName);
+        Codebook decodedCodebook;
+        if (error_type status; (status = HuffmanDecoder::readHeader(hdrFileForDecode, decodedCodebook)) != NO_ERROR)
+            return stopOnError(options, status, hdrFileName);
+
+        EncodedBits encodedBits;
+        if (error_type status; (status = HuffmanDecoder::loadCodeFile(codeFileName, encodedBits)) != NO_ERROR)
+            return stopOnError(options, status, codeFileName);
+
+        const HuffmanDecoder decoder(decodedCodebook);
+        std::string decoded;
+        const auto start = std::chrono::steady_clock::now();
+        if (error_type status; (status = decoder.decode(encodedBits.data, encodedBits.totalBits, decoded)) != NO_ERROR)
+            return stopOnError(options, status, codeFileName);
+        const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+        // the decoded text should be the .tokens file, byte for byte
+        MappedFile tokensFile;
+        if (error_type status; (status = tokensFile.open(wordTokensFileName)) != NO_ERROR)
+            return stopOnError(options, status, wordTokensFileName);
+        const bool matches = tokensFile.view() == decoded;
+
+        out << "Decoded matches .tokens: " << (matches ? "yes" : "NO") << '\n';
+        out << "Decode speed: " << std::fixed << std::setprecision(1)
+            << (seconds.count() > 0 ? static_cast<double>(decoded.size()) / 1e6 / seconds.count() : 0.0)
+            << " MB/s (" << decoded.size() << " bytes of text)\n" << std::defaultfloat;
+        if (!matches)
+            return 1;
+
+        // with an index: decode again in slices from the sync points, and check that matches too
+        if (index != nullptr) {
+            std::ifstream indexFile(indexFileName, std::ios::in | std::ios::binary);
+            SyncIndex readIndex;
+            if (error_type status; (status = readIndex.read(indexFile)) != NO_ERROR)
+                return stopOnError(options, status, indexFileName);
+
+            const unsigned threads = resolveThreadCount(options.decodeThreads);
+            std::string sliced;
+            const auto sliceStart = std::chrono::steady_clock::now();
+            if (error_type status; (status = decoder.decodeParallel(encodedBits, readIndex, threads, sliced)) != NO_ERROR)
+                return stopOnError(options, status, codeFileName);
+            const std::chrono::duration<double> sliceSeconds = std::chrono::steady_clock::now() - sliceStart;
+
+            const bool slicesMatch = sliced == decoded;
+            out << "Decoded from sync points on " << threads << " thread(s) matches: " << (slicesMatch ? "yes" : "NO")
+                << " (" << std::fixed << std::setprecision(1)
+                << (sliceSeconds.count() > 0 ? static_cast<double>(sliced.size()) / 1e6 / sliceSeconds.count() : 0.0)
+                << " MB/s)\n" << std::defaultfloat;
+            if (!slicesMatch)
+                return 1;
         }
     }
-    codeFileForCount.close();
 
-    std::cout << "Total letters in input words: " << totalLetters << '\n';
-    std::cout << "Total bits in encoded words: " << totalBits << '\n';
+
+    // ========== PROFILE (--profile) ==========
+    if (profiler.enabled()) {
+        profiler.finish();
+        profiler.writeJsonLines(out, inputFileName);
+
+        if (!options.profileTrace.empty()) {
+            std::ofstream traceFile(options.profileTrace, std::ios::out | std::ios::trunc);
+            if (!traceFile.is_open())
+                return stopOnError(options, UNABLE_TO_OPEN_FILE_FOR_WRITING, options.profileTrace);
+            profiler.writeChromeTrace(traceFile);
+        }
+    }
 
 
-    // ========== STEP 10: CLEANUP ==========
-    // The HuffmanTree destructor will automatically clean up all nodes it owns
-    // No manual cleanup needed here!
+    // ========== STEP 11: CLEANUP ==========
+    // The BST, the HuffmanTree and freqArena each release all of their nodes at once
+    // when they go out of scope. No manual cleanup needed here!
 
     return 0;
-}
\ No newline at end of file
+}
+
+
+// files smaller than this are never split across the batch workers; slicing them costs more than it saves
+static constexpr std::uintmax_t kMinSplitFileBytes = 1 << 20;
+
+// --batch: every input on a work-stealing pool, largest first; each file's report is printed (in input order)
+// once they're all done, then the totals.
+static int runBatch(const Options& options) {
+    // a directory means every .txt in it; anything else is a list of inputs, one per line
+    std::vector<std::string> inputs;
+    if (std::filesystem::is_directory(options.inputFileName)) {
+        for (const auto& entry : std::filesystem::directory_iterator(options.inputFileName)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".txt")
+                inputs.push_back(entry.path().string());
+        }
+        std::sort(inputs.begin(), inputs.end());
+    }
+    else {
+        std::ifstream list(options.inputFileName);
+        if (!list.is_open())
+            exitOnError(UNABLE_TO_OPEN_FILE, options.inputFileName);
+        for (std::string line; std::getline(list, line); ) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!line.empty())
+                inputs.push_back(line);
+        }
+    }
+
+    // every file's outputs land in input_output under its base name, so two inputs can't share one
+    std::vector<std::string> baseNames;
+    for (const auto& input : inputs)
+        baseNames.push_back(baseNameWithoutTxt(input));
+    std::sort(baseNames.begin(), baseNames.end());
+    if (const auto same = std::adjacent_find(baseNames.begin(), baseNames.end()); same != baseNames.end()) {
+        std::cerr << "Error: more than one input is named " << *same << "; their output files would collide\n";
+        return 1;
+    }
+
+    // biggest first, so a huge file doesn't start last and hold up the end of the batch
+    std::vector<std::uintmax_t> sizes(inputs.size(), 0);
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        std::error_code error;
+        const std::uintmax_t size = std::filesystem::file_size(inputs[i], error);
+        sizes[i] = error ? 0 : size;
+    }
+    std::vector<std::size_t> order(inputs.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](const std::size_t a, const std::size_t b) { return sizes[a] > sizes[b]; });
+
+    std::vector<std::string> reports(inputs.size());
+    std::vector<int> exitCodes(inputs.size(), 0);
+    const unsigned threads = resolveThreadCount(options.batchThreads);
+
+    // A file bigger than its fair share of the batch would keep one worker busy long after the rest ran out of
+    // files, so it's tokenized and encoded in slices instead. The slices go onto the same work-stealing queues
+    // (runOnThreads does that inside the pool), so idle workers pick them up without adding threads.
+    // Only modes that can split are split, and a thread count given on the command line is left alone.
+    const std::uintmax_t totalSize = std::accumulate(sizes.begin(), sizes.end(), std::uintmax_t{0});
+    const bool canSplitEncode = !options.streaming && !options.adaptive && options.blockTokens == 0 && options.encodeThreads == 1;
+    const bool canSplitScan = canSplitEncode && !options.interning && options.scanThreads == 1;
+    std::vector<bool> split(inputs.size(), false);
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+        split[i] = threads > 1 && canSplitEncode && sizes[i] >= kMinSplitFileBytes && sizes[i] * threads > totalSize;
+
+    const auto start = std::chrono::steady_clock::now();
+    runWorkStealing(order.size(), threads, [&](const std::size_t k) {
+        const std::size_t i = order[k];
+        Options fileOptions = options;
+        fileOptions.inputFileName = inputs[i];
+        if (split[i]) {
+            fileOptions.encodeThreads = threads;
+            if (canSplitScan) {
+                // the sliced tokenizer works on the mapped file (same tokens as the streamed one)
+                fileOptions.useMmap = true;
+                fileOptions.scanThreads = threads;
+            }
+        }
+
+        std::ostringstream out;
+        exitCodes[i] = processFile(fileOptions, out);
+        reports[i] = out.str();
+    });
+    const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+    std::size_t failed = 0;
+    std::uintmax_t totalBytes = 0;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        std::cout << "==> " << inputs[i] << (exitCodes[i] == 0 ? "" : " (FAILED)")
+                  << (split[i] ? " (split across the workers)" : "") << '\n' << reports[i];
+        totalBytes += sizes[i];
+        if (exitCodes[i] != 0)
+            failed++;
+    }
+
+    const double elapsed = seconds.count() > 0 ? seconds.count() : 1e-9;
+    std::cout << "Batch: " << inputs.size() << " files (" << failed << " failed), " << totalBytes << " bytes on "
+              << threads << " thread(s) in " << std::fixed << std::setprecision(3) << seconds.count() << " s: "
+              << std::setprecision(1) << static_cast<double>(inputs.size()) / elapsed << " files/s, "
+              << static_cast<double>(totalBytes) / 1e6 / elapsed << " MB/s\n" << std::defaultfloat;
+
+    return failed == 0 ? 0 : 1;
+}
+
+
+int main(int argc, char *argv[]) {
+
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--mmap] [--simd=auto|scalar|sse2|avx2] [--threads=N] [--encode-threads=N] [--stream | --intern | --adaptive | --block-size=N] [--bst-depths] [--counter=bst|hash] [--huffman=pq|two-queue] [--canonical] [--max-code-length=L] [--binary] [--sync-every=N] [--decode-threads=N] [--stats] [--verify] [--profile] [--profile-trace=FILE] [--batch] [--batch-threads=N] <filename | directory | file list>\n";
+        return 1;
+    }
+
+    if (!options.batch)
+        return processFile(options, std::cout);
+
+    return runBatch(options);
+}
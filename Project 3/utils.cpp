@@ -7,32 +7,48 @@
 #include <fstream>
 #include <vector>
 #include "utils.hpp"
+#include "OutputBuffer.hpp"
 
 
-void exitOnError(error_type error, const std::string &entityName = "") {
+std::string errorMessage(error_type error, const std::string &entityName) {
     switch (error) {
         case NO_ERROR:
-            // do nothing
-            return;
+            return "";
 
         case FILE_NOT_FOUND:
-            std::cerr << "Error: File " << entityName << " doesn't exist. Terminating...\n";
-            exit(FILE_NOT_FOUND);
+            return "Error: File " + entityName + " doesn't exist.";
 
         case UNABLE_TO_OPEN_FILE:
-            std::cerr << "Error: Unable to open '" << entityName << "'. Terminating...\n";
-            exit(UNABLE_TO_OPEN_FILE);
+            return "Error: Unable to open '" + entityName + "'.";
 
         case DIR_NOT_FOUND:
-            std::cerr << "Error: Directory " << entityName << " doesn't exist. Terminating...\n";
-            exit(DIR_NOT_FOUND);
+            return "Error: Directory " + entityName + " doesn't exist.";
 
         case UNABLE_TO_OPEN_FILE_FOR_WRITING:
-            std::cerr << "Error: Unable to open " << entityName << " for writing. Terminating...\n";
-            exit(UNABLE_TO_OPEN_FILE_FOR_WRITING);
+            return "Error: Unable to open " + entityName + " for writing.";
+
+        case INVALID_FILE_FORMAT:
+            return "Error: " + entityName + " isn't in the expected format.";
+
+        default:
+            return "Error: Unknown error type.";
+    }
+}
+
+void exitOnError(error_type error, const std::string &entityName = "") {
+    if (error == NO_ERROR)
+        return; // do nothing
+
+    std::cerr << errorMessage(error, entityName) << " Terminating...\n";
+    switch (error) {
+        case FILE_NOT_FOUND:
+        case UNABLE_TO_OPEN_FILE:
+        case DIR_NOT_FOUND:
+        case UNABLE_TO_OPEN_FILE_FOR_WRITING:
+        case INVALID_FILE_FORMAT:
+            exit(error);
 
         default:
-            std::cerr << "Error: Unknown error type. Terminating...\n";
             exit(ERR_TYPE_NOT_FOUND);
     }
 }
@@ -71,6 +87,18 @@ error_type regularFileExistsAndIsAvailable(const std::string &filename) {
 }
 
 
+bool isLiveInput(const std::string& name) {
+    // these can't be mapped or read twice; the data shows up while we read it
+    if (name == "-")
+        return true;
+
+    namespace fs = std::filesystem;
+    std::error_code error;
+    const fs::file_status status = fs::status(name, error);
+    return !error && (fs::is_fifo(status) || fs::is_socket(status) || fs::is_character_file(status));
+}
+
+
 std::string baseNameWithoutTxt(const std::string& filename) {
     // "filename" is expected to have .txt extension.
     // Return the base-name of the "filename".
@@ -107,12 +135,16 @@ error_type writeVectorToFile(const std::string& filename,
         return UNABLE_TO_OPEN_FILE_FOR_WRITING;
     }
 
+    // the lines collect in one big block that goes out a chunk at a time
+    OutputBuffer buffer(out);
     for (const auto& item : data) {
-        out << item << '\n';
-        if (!out) {
-            std::cerr << "Error: failed while writing to " << filename << "\n";
-            return FAILED_TO_WRITE_FILE;
-        }
+        buffer.write(item);
+        buffer.put('\n');
+    }
+
+    if (buffer.flush() != NO_ERROR) {
+        std::cerr << "Error: failed while writing to " << filename << "\n";
+        return FAILED_TO_WRITE_FILE;
     }
 
     return NO_ERROR;
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #ifndef IMPLEMENTATION_UTILS_HPP
 #define IMPLEMENTATION_UTILS_HPP
@@ -17,13 +18,16 @@ enum error_type {
     ERR_TYPE_NOT_FOUND,
     UNABLE_TO_OPEN_FILE_FOR_WRITING,
     FAILED_TO_WRITE_FILE,
+    INVALID_FILE_FORMAT,
 };
 
 void exitOnError(error_type error, const std::string& entityName);
+std::string errorMessage(error_type error, const std::string& entityName); // what exitOnError prints, minus "Terminating..."
 error_type regularFileExistsAndIsAvailable(const std::string &fileName);
 error_type fileExists(const std::string &name);
 error_type directoryExists(const std::string &name);
 error_type regularFileExists(const std::string &name);
+bool isLiveInput(const std::string& name); // "-" (stdin), or an existing FIFO, socket or character device
 std::string baseNameWithoutTxt(const std::string& filename);
 error_type canOpenForWriting(const std::string& filename);
 error_type writeVectorToFile(const std::string& filename,